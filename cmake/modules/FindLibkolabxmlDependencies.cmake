@@ -30,13 +30,6 @@ endif()
 find_package_handle_standard_args(Xerces  DEFAULT_MSG
                                   XERCES_C XERCES_C_INCLUDE_DIRS)
 
-find_library(CURL NAMES curl)
-if (CURL)
-    find_path(CURL_INCLUDE_DIRS NAMES curl/curl.h)
-endif()
-find_package_handle_standard_args(Curl  DEFAULT_MSG
-                                  CURL CURL_INCLUDE_DIRS)
-
 find_program(SWIG swig /usr/bin/)
 if(SWIG)
     set(SWIG_FOUND ON)
@@ -51,4 +44,4 @@ endif()
 
 #abort if any of the requireds are missing
 find_package_handle_standard_args(LibkolabxmlDependencies  DEFAULT_MSG
-                                  UUID_LIBRARY_FOUND XSDCXX XERCES_C CURL)
+                                  UUID_LIBRARY_FOUND XSDCXX XERCES_C)
@@ -19,11 +19,12 @@
 
 #include <memory>   // std::auto_ptr
 #include <fstream>
-#include <iostream>
+#include <sstream>
 
 #include <xercesc/dom/DOM.hpp>
 #include <xercesc/util/XMLUniDefs.hpp> // chLatin_*
 #include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/OutOfMemoryException.hpp>
 #include <xercesc/validators/common/Grammar.hpp> // xercesc::Grammar
 #include <xercesc/framework/Wrapper4InputSource.hpp>
 
@@ -38,12 +39,250 @@
 #include <xsd/cxx/xml/dom/bits/error-handler-proxy.hxx>
 #include <xsd/cxx/xml/sax/std-input-source.hxx>
 
+#include <xsd/cxx/xml/dom/serialization-source.hxx>
+
 #include <xsd/cxx/tree/error-handler.hxx>
+#include <xsd/cxx/tree/exceptions.hxx>
 
 #include <boost/thread.hpp>
+#include <vector>
 
 #include "kolabformat-xcal-schema.hxx"
 #include "grammar-input-stream.hxx"
+#include "../src/utils.h"
+#include "../src/instrumentation.h"
+#include "../src/memoryaccounting.h"
+#include "../src/resourcelimits.h"
+
+/**
+ * Accounts the memory Xerces allocates for the library (the DOM, the parser buffers, ...) to the allocating thread.
+ *
+ * It is only handed to the parsers, the grammar pool and the documents the library creates, not installed for the whole process.
+ *
+ * The size of each allocation is stored in front of the returned block, so it is known on deallocation.
+ */
+class CountingMemoryManager : public xercesc::MemoryManager
+{
+public:
+    virtual ~CountingMemoryManager() {};
+
+#if _XERCES_VERSION >= 30000
+    virtual xercesc::MemoryManager *getExceptionMemoryManager()
+    {
+        return this;
+    }
+
+    virtual void *allocate(XMLSize_t size)
+#else
+    virtual void *allocate(size_t size)
+#endif
+    {
+        void *block;
+        try {
+            block = ::operator new(sizeof(Header) + size);
+        } catch (...) {
+            throw xercesc::OutOfMemoryException();
+        }
+        static_cast<Header*>(block)->size = size;
+        Kolab::Utils::accountAllocation(size);
+        return static_cast<char*>(block) + sizeof(Header);
+    }
+
+    virtual void deallocate(void *p)
+    {
+        if (!p) {
+            return;
+        }
+        void *block = static_cast<char*>(p) - sizeof(Header);
+        Kolab::Utils::accountDeallocation(static_cast<Header*>(block)->size);
+        ::operator delete(block);
+    }
+
+private:
+    //Keeps the returned blocks aligned like the ones of operator new
+    union Header {
+        std::size_t size;
+        long double alignLongDouble;
+        void *alignPointer;
+    };
+};
+
+//Stateless, so it can't be destroyed while Xerces still uses it
+static CountingMemoryManager countingMemoryManager;
+
+#if _XERCES_VERSION >= 30000
+/**
+ * Enforces the element count and time limits while parsing, so an oversized document is aborted early.
+ */
+class LimitFilter : public xercesc::DOMLSParserFilter
+{
+public:
+    LimitFilter(): elements(0), exceeded(false) {};
+
+    virtual FilterAction acceptNode(xercesc::DOMNode *)
+    {
+        return FILTER_ACCEPT;
+    }
+
+    virtual FilterAction startElement(xercesc::DOMElement *)
+    {
+        elements++;
+        if (Kolab::Utils::exceedsElementCount(elements) || Kolab::Utils::exceedsTime()) {
+            exceeded = true;
+            return FILTER_INTERRUPT;
+        }
+        return FILTER_ACCEPT;
+    }
+
+    virtual xercesc::DOMNodeFilter::ShowType getWhatToShow() const
+    {
+        return xercesc::DOMNodeFilter::SHOW_ELEMENT;
+    }
+
+    unsigned long elements;
+    bool exceeded;
+};
+#else
+/**
+ * Xerces-C++ 2 has no way to interrupt the parser, so the limits are checked on the parsed document.
+ */
+static bool exceedsLimits(const xercesc::DOMNode *root)
+{
+    unsigned long elements = 0;
+    const xercesc::DOMNode *node = root;
+    while (node) {
+        if (node->getNodeType() == xercesc::DOMNode::ELEMENT_NODE) {
+            elements++;
+        }
+        if (node->getFirstChild()) {
+            node = node->getFirstChild();
+            continue;
+        }
+        while (node && node != root && !node->getNextSibling()) {
+            node = node->getParentNode();
+        }
+        node = (node && node != root) ? node->getNextSibling() : 0;
+    }
+    return Kolab::Utils::exceedsElementCount(elements) || Kolab::Utils::exceedsTime();
+}
+#endif
+
+/*
+ * State shared by the parsers of all threads, protected by sharedMutex.
+ *
+ * Xerces is initialized once for the process: the parsers and the process itself hold references, and Terminate is only
+ * called when the last one is released. The process reference is taken by initialize() or implicitly on first use, and only
+ * released by shutdown(), so threads coming and going don't (re)initialize Xerces or reload the grammar.
+ * Only one Initialize/Terminate pair is issued, which is balanced with those of a host application also using Xerces.
+ *
+ * The grammar pool is locked once loaded, so the parsers of all threads can use it concurrently.
+ */
+static boost::mutex sharedMutex;
+static const bool sharedMutexProtected = Kolab::Utils::protectAcrossFork(sharedMutex);
+static unsigned int platformUsers = 0;
+static xercesc::XMLGrammarPool *sharedGrammarPool = 0;
+static unsigned int grammarPoolUsers = 0;
+/*
+ * Parsers which are not used by any thread: the ones created by initialize() and the ones returned to the pool.
+ * Ordered by the time they became idle, so the ones idle for longest are in front.
+ */
+struct IdleParser {
+    XMLParserWrapper *parser;
+    unsigned long long since;
+};
+static std::vector<IdleParser> idleParsers;
+//0 for one parser per thread
+static unsigned int maxPooledParsers = 0;
+//In milliseconds, 0 to keep idle parsers
+static unsigned long idleTimeout = 0;
+static unsigned int checkedOutParsers = 0;
+static boost::condition_variable parserReturned;
+static unsigned int initializeCount = 0;
+static bool implicitReference = false;
+static bool processHoldsGrammarPool = false;
+
+static void acquirePlatform()
+{
+    if (!platformUsers++) {
+        //The counting memory manager is passed to the parsers, grammar pool and documents explicitly,
+        //so the allocations of a host application also using Xerces are not routed through it
+        xercesc::XMLPlatformUtils::Initialize ();
+    }
+}
+
+static void releasePlatform()
+{
+    if (!--platformUsers) {
+        xercesc::XMLPlatformUtils::Terminate ();
+    }
+}
+
+/*
+ * trace reports the loading of the grammar once sharedMutex is released.
+ */
+static xercesc::XMLGrammarPool *acquireGrammarPool(Kolab::Utils::DeferredTrace &trace)
+{
+    using namespace xercesc;
+    if (!sharedGrammarPool) {
+        // Create and load the grammar pool.
+        //
+        XMLGrammarPool *gp = new XMLGrammarPoolImpl (&countingMemoryManager);
+        trace.begin("loadGrammar", Kolab::UnknownObject, sizeof (iCalendar_schema));
+        try
+        {
+            grammar_input_stream is (iCalendar_schema, sizeof (iCalendar_schema));
+            gp->deserializeGrammars(&is);
+        }
+        catch(const XSerializationException& e)
+        {
+            Kolab::Utils::logDiagnostic(Kolab::Diagnostic(Kolab::Critical, Kolab::GenericError, "unable to load schema: " + xsd::cxx::xml::transcode<char> (e.getMessage ())));
+            trace.end();
+            delete gp;
+            return 0;
+        }
+        trace.end();
+
+        // Lock the grammar pool. This is necessary if we plan to use the
+        // same grammar pool in multiple threads (this way we can reuse the
+        // same grammar in multiple parsers). Locking the pool disallows any
+        // modifications to the pool, such as an attempt by one of the threads
+        // to cache additional schemas.
+        //
+        gp->lockPool ();
+        sharedGrammarPool = gp;
+    }
+    grammarPoolUsers++;
+    return sharedGrammarPool;
+}
+
+static void releaseGrammarPool()
+{
+    if (!--grammarPoolUsers) {
+        delete sharedGrammarPool;
+        sharedGrammarPool = 0;
+    }
+}
+
+static bool holdsProcessReference()
+{
+    return initializeCount || implicitReference;
+}
+
+static bool acquireProcessReference(Kolab::Utils::DeferredTrace &trace)
+{
+    acquirePlatform();
+    processHoldsGrammarPool = acquireGrammarPool(trace);
+    return processHoldsGrammarPool;
+}
+
+static void releaseProcessReference()
+{
+    if (processHoldsGrammarPool) {
+        releaseGrammarPool();
+        processHoldsGrammarPool = false;
+    }
+    releasePlatform();
+}
 
 XMLParserWrapper::XMLParserWrapper()
 :   ehp(eh),
@@ -53,7 +292,15 @@ XMLParserWrapper::XMLParserWrapper()
     // We need to initialize the Xerces-C++ runtime because we
     // are doing the XML-to-DOM parsing ourselves.
     //
-    xercesc::XMLPlatformUtils::Initialize ();
+    {
+        Kolab::Utils::DeferredTrace trace;
+        boost::mutex::scoped_lock lock(sharedMutex);
+        if (!holdsProcessReference()) {
+            acquireProcessReference(trace);
+            implicitReference = true;
+        }
+        acquirePlatform();
+    }
     init();
 }
 
@@ -61,23 +308,221 @@ XMLParserWrapper::XMLParserWrapper()
 XMLParserWrapper::~XMLParserWrapper()
 {
     delete parser;
-    delete gp;
-    xercesc::XMLPlatformUtils::Terminate ();
-
+    boost::mutex::scoped_lock lock(sharedMutex);
+    if (gp) {
+        releaseGrammarPool();
+    }
+    releasePlatform();
 }
 
 boost::thread_specific_ptr<XMLParserWrapper> ptr;
 
+static void addIdleParser(XMLParserWrapper *parser)
+{
+    IdleParser idle;
+    idle.parser = parser;
+    idle.since = Kolab::Utils::monotonicTime();
+    idleParsers.push_back(idle);
+}
+
+//Takes the most recently used idle parser (or 0), so the ones which are not needed anymore can expire
+static XMLParserWrapper *takeIdleParser()
+{
+    if (idleParsers.empty()) {
+        return 0;
+    }
+    XMLParserWrapper *parser = idleParsers.back().parser;
+    idleParsers.pop_back();
+    return parser;
+}
+
+//The parsers are deleted by the caller, after releasing the mutex (the destructor takes it again)
+static void takeExpiredParsers(std::vector<XMLParserWrapper*> &expired)
+{
+    if (!idleTimeout) {
+        return;
+    }
+    const unsigned long long now = Kolab::Utils::monotonicTime();
+    std::vector<IdleParser>::iterator end = idleParsers.begin();
+    while (end != idleParsers.end() && now - end->since > idleTimeout * 1000000ull) {
+        expired.push_back(end->parser);
+        ++end;
+    }
+    idleParsers.erase(idleParsers.begin(), end);
+}
+
+static void deleteParsers(const std::vector<XMLParserWrapper*> &parsers)
+{
+    for (std::vector<XMLParserWrapper*>::const_iterator it = parsers.begin(); it != parsers.end(); ++it) {
+        delete *it;
+    }
+}
+
+XMLParserWrapper::Lease::Lease()
+:   mParser(0),
+    mPooled(false)
+{
+    std::vector<XMLParserWrapper*> expired;
+    {
+        boost::mutex::scoped_lock lock(sharedMutex);
+        while (maxPooledParsers && idleParsers.empty() && checkedOutParsers >= maxPooledParsers) {
+            parserReturned.wait(lock);
+        }
+        mPooled = maxPooledParsers != 0;
+        if (mPooled) {
+            checkedOutParsers++;
+            takeExpiredParsers(expired);
+            mParser = takeIdleParser();
+        }
+    }
+    deleteParsers(expired);
+    if (!mPooled) {
+        mParser = &inst();
+    } else if (!mParser) {
+        mParser = new XMLParserWrapper();
+    }
+}
+
+XMLParserWrapper::Lease::~Lease()
+{
+    if (!mPooled) {
+        return;
+    }
+    std::vector<XMLParserWrapper*> expired;
+    {
+        boost::mutex::scoped_lock lock(sharedMutex);
+        checkedOutParsers--;
+        takeExpiredParsers(expired);
+        if (idleParsers.size() < maxPooledParsers) {
+            addIdleParser(mParser);
+        } else {
+            expired.push_back(mParser);
+        }
+        parserReturned.notify_one();
+    }
+    deleteParsers(expired);
+}
+
 XMLParserWrapper& XMLParserWrapper::inst()
 {
     XMLParserWrapper *t = ptr.get();
     if (!t) {
-        t = new XMLParserWrapper();
+        {
+            boost::mutex::scoped_lock lock(sharedMutex);
+            t = takeIdleParser();
+        }
+        if (!t) {
+            t = new XMLParserWrapper();
+        }
         ptr.reset(t);
     }
     return *t;
 }
 
+bool XMLParserWrapper::initialize(unsigned int parsers, const std::string &warmupDocument)
+{
+    bool pooled;
+    {
+        Kolab::Utils::DeferredTrace trace;
+        boost::mutex::scoped_lock lock(sharedMutex);
+        if (!holdsProcessReference() && !acquireProcessReference(trace)) {
+            releaseProcessReference();
+            return false;
+        }
+        initializeCount++;
+        pooled = maxPooledParsers != 0;
+    }
+
+    //With a pool the calling thread doesn't get a parser of its own
+    std::vector<XMLParserWrapper*> created;
+    created.reserve(parsers + 1);
+    if (!pooled) {
+        created.push_back(&inst());
+    }
+    for (unsigned int i = 0; i < parsers; i++) {
+        created.push_back(new XMLParserWrapper());
+    }
+    //Parsing a document once allocates the parser buffers and fills the caches of the allocator
+    if (!warmupDocument.empty()) {
+        for (std::vector<XMLParserWrapper*>::const_iterator it = created.begin(); it != created.end(); ++it) {
+            (*it)->parseString(warmupDocument);
+        }
+    }
+
+    boost::mutex::scoped_lock lock(sharedMutex);
+    for (std::vector<XMLParserWrapper*>::const_iterator it = created.begin() + (pooled ? 0 : 1); it != created.end(); ++it) {
+        addIdleParser(*it);
+    }
+    return processHoldsGrammarPool;
+}
+
+void XMLParserWrapper::shutdown()
+{
+    std::vector<XMLParserWrapper*> spares;
+    {
+        boost::mutex::scoped_lock lock(sharedMutex);
+        if (initializeCount > 1) {
+            initializeCount--;
+            return;
+        }
+        if (!holdsProcessReference()) {
+            return;
+        }
+        initializeCount = 0;
+        implicitReference = false;
+        while (XMLParserWrapper *parser = takeIdleParser()) {
+            spares.push_back(parser);
+        }
+    }
+    deleteParsers(spares);
+    ptr.reset();
+
+    boost::mutex::scoped_lock lock(sharedMutex);
+    releaseProcessReference();
+}
+
+void XMLParserWrapper::ensureInitialized()
+{
+    Kolab::Utils::DeferredTrace trace;
+    boost::mutex::scoped_lock lock(sharedMutex);
+    if (!maxPooledParsers) {
+        lock.unlock();
+        //The parser of the calling thread holds a reference on Xerces
+        inst();
+    } else if (!holdsProcessReference()) {
+        acquireProcessReference(trace);
+        implicitReference = true;
+    }
+}
+
+void XMLParserWrapper::setPool(unsigned int maxParsers, unsigned long timeout)
+{
+    std::vector<XMLParserWrapper*> expired;
+    {
+        boost::mutex::scoped_lock lock(sharedMutex);
+        maxPooledParsers = maxParsers;
+        idleTimeout = timeout;
+        takeExpiredParsers(expired);
+        while (maxPooledParsers && idleParsers.size() > maxPooledParsers) {
+            expired.push_back(idleParsers.front().parser);
+            idleParsers.erase(idleParsers.begin());
+        }
+        parserReturned.notify_all();
+    }
+    deleteParsers(expired);
+}
+
+void XMLParserWrapper::releaseThreadResources()
+{
+    ptr.reset();
+    std::vector<XMLParserWrapper*> expired;
+    {
+        boost::mutex::scoped_lock lock(sharedMutex);
+        takeExpiredParsers(expired);
+    }
+    deleteParsers(expired);
+}
+
 
 void XMLParserWrapper::init()
 {
@@ -91,31 +536,17 @@ void XMLParserWrapper::init()
         using namespace xercesc;
         namespace xml = xsd::cxx::xml;
         namespace tree = xsd::cxx::tree;
-        // Create and load the grammar pool.
-        //
-        MemoryManager* mm (XMLPlatformUtils::fgMemoryManager);
-
-        gp = new XMLGrammarPoolImpl (mm);
+        MemoryManager* mm (&countingMemoryManager);
 
-        try
         {
-            grammar_input_stream is (iCalendar_schema, sizeof (iCalendar_schema));
-            gp->deserializeGrammars(&is);
+            Kolab::Utils::DeferredTrace trace;
+            boost::mutex::scoped_lock lock(sharedMutex);
+            gp = acquireGrammarPool(trace);
         }
-        catch(const XSerializationException& e)
-        {
-            cerr << "unable to load schema: " << xml::transcode<char> (e.getMessage ()) << endl;
+        if (!gp) {
             return;
         }
 
-        // Lock the grammar pool. This is necessary if we plan to use the
-        // same grammar pool in multiple threads (this way we can reuse the
-        // same grammar in multiple parsers). Locking the pool disallows any
-        // modifications to the pool, such as an attempt by one of the threads
-        // to cache additional schemas.
-        //
-        gp->lockPool ();
-
         // Get an implementation of the Load-Store (LS) interface.
         //
         const XMLCh ls_id [] = {chLatin_L, chLatin_S, chNull};
@@ -218,10 +649,9 @@ void XMLParserWrapper::init()
         
     }
     catch (const xml_schema::exception& e) {
-        cout << "schema exception" << endl;
-        cerr << e << endl;
+        reportException(e, Kolab::GenericError);
     } catch (const std::ios_base::failure&) {
-        cerr << ": unable to open or read failure" << endl;
+        Kolab::Utils::logDiagnostic(Kolab::Diagnostic(Kolab::Critical, Kolab::GenericError, "unable to open or read failure"));
     }
     
 }
@@ -232,16 +662,26 @@ xsd::cxx::xml::dom::auto_ptr< xercesc::DOMDocument > XMLParserWrapper::parseFile
         std::ifstream ifs;
         ifs.exceptions (std::ifstream::badbit | std::ifstream::failbit); //TODO handle exceptions
         ifs.open (url.c_str());
+        if (Kolab::Utils::getResourceLimits().maxInputSize) {
+            ifs.seekg(0, std::ios::end);
+            if (Kolab::Utils::exceedsInputSize(static_cast<std::size_t>(ifs.tellg()))) {
+                return xsd::cxx::xml::dom::auto_ptr< xercesc::DOMDocument >();
+            }
+            ifs.seekg(0, std::ios::beg);
+        }
         return parse(ifs, url);
     } catch (const std::ios_base::failure&)
     {
-        std::cerr << ": unable to open or read failure" << std::endl;
+        Kolab::Utils::logDiagnostic(Kolab::Diagnostic(Kolab::Error, Kolab::ParseError, "unable to open or read " + url));
     }
     return xsd::cxx::xml::dom::auto_ptr< xercesc::DOMDocument >();
 }
 
 xsd::cxx::xml::dom::auto_ptr< xercesc::DOMDocument > XMLParserWrapper::parseString(const std::string& s)
 {
+    if (Kolab::Utils::exceedsInputSize(s.size())) {
+        return xsd::cxx::xml::dom::auto_ptr< xercesc::DOMDocument >();
+    }
     std::istringstream is(s);
     return parse(is, ""); //TODO set identifier?
 }
@@ -250,6 +690,13 @@ xsd::cxx::xml::dom::auto_ptr< xercesc::DOMDocument > XMLParserWrapper::parseStri
 xml_schema::dom::auto_ptr<xercesc::DOMDocument> XMLParserWrapper::parse(std::istream &ifs, const std::string &name)
 {
     using namespace std;
+    Kolab::Utils::PhaseTimer timer(Kolab::ParsePhase);
+    const Kolab::ResourceLimits &limits = Kolab::Utils::getResourceLimits();
+    const bool limited = limits.maxElementCount || limits.maxTime;
+#if _XERCES_VERSION >= 30000
+    LimitFilter filter;
+    parser->setFilter(limited ? &filter : 0);
+#endif
 
     try
     {
@@ -274,22 +721,78 @@ xml_schema::dom::auto_ptr<xercesc::DOMDocument> XMLParserWrapper::parse(std::ist
         #endif
 
             eh.throw_if_failed<xml_schema::parsing> ();
+        #if _XERCES_VERSION < 30000
+            if (limited && doc.get() && exceedsLimits(doc.get())) {
+                return xml_schema::dom::auto_ptr<xercesc::DOMDocument>();
+            }
+        #endif
             return doc;
         }
     }
     catch (const xml_schema::exception& e)
     {
-        cerr << "schema exception" << endl;
-        cerr << e << endl;
+        reportException(e, Kolab::ParseError);
     }
     catch (const std::ios_base::failure&)
     {
-        cerr << ": unable to open or read failure" << endl;
+        Kolab::Utils::logDiagnostic(Kolab::Diagnostic(Kolab::Error, Kolab::ParseError, "unable to open or read failure"));
     }
+#if _XERCES_VERSION >= 30000
+    catch (const xercesc::DOMException &e)
+    {
+        //An interruption by the filter has already been reported
+        if (!filter.exceeded) {
+            Kolab::Utils::logDiagnostic(Kolab::Diagnostic(Kolab::Error, Kolab::ParseError, xsd::cxx::xml::transcode<char>(e.getMessage())));
+        }
+    }
+#endif
     catch (...)
     {
-        cerr << ": unknown exception thrown" << endl;
+        Kolab::Utils::logDiagnostic(Kolab::Diagnostic(Kolab::Error, Kolab::ParseError, "unknown exception thrown"));
     }
     eh.reset();
     return xml_schema::dom::auto_ptr<xercesc::DOMDocument>();
 }
+
+xml_schema::dom::auto_ptr<xercesc::DOMDocument> XMLParserWrapper::createDocument(const std::string &rootElement, const std::string &ns, const xml_schema::namespace_infomap &map)
+{
+    using namespace xercesc;
+    namespace xml = xsd::cxx::xml;
+
+    const XMLCh ls_id [] = {chLatin_L, chLatin_S, chNull};
+    DOMImplementation* impl (DOMImplementationRegistry::getDOMImplementation (ls_id));
+    xml_schema::dom::auto_ptr<DOMDocument> doc (impl->createDocument (xml::string (ns).c_str (), xml::string (rootElement).c_str (), 0, &countingMemoryManager));
+
+    DOMElement* root (doc->getDocumentElement ());
+    for (xml_schema::namespace_infomap::const_iterator it = map.begin(); it != map.end(); ++it) {
+        const std::string name = it->first.empty() ? std::string("xmlns") : "xmlns:" + it->first;
+        root->setAttributeNS (XMLUni::fgXMLNSURIName, xml::string (name).c_str (), xml::string (it->second.name).c_str ());
+    }
+    return doc;
+}
+
+void XMLParserWrapper::writeDocument(std::ostream &os, const xercesc::DOMDocument &doc)
+{
+    xsd::cxx::tree::error_handler<char> h;
+    xsd::cxx::xml::dom::ostream_format_target t (os);
+    if (!xsd::cxx::xml::dom::serialize (t, doc, std::string("UTF-8"), h, xml_schema::flags::dont_initialize)) {
+        h.throw_if_failed<xsd::cxx::tree::serialization<char> > ();
+    }
+}
+
+void XMLParserWrapper::reportException(const xml_schema::exception &e, Kolab::DiagnosticCode code)
+{
+    if (const xml_schema::parsing *parsing = dynamic_cast<const xml_schema::parsing*>(&e)) {
+        const xml_schema::diagnostics &diagnostics = parsing->diagnostics();
+        if (!diagnostics.empty()) {
+            for (xml_schema::diagnostics::const_iterator it = diagnostics.begin(); it != diagnostics.end(); ++it) {
+                const Kolab::ErrorSeverity severity = (it->severity() == xsd::cxx::tree::severity::warning) ? Kolab::Warning : Kolab::Error;
+                Kolab::Utils::logDiagnostic(Kolab::Diagnostic(severity, code, it->message(), it->line(), it->column()));
+            }
+            return;
+        }
+    }
+    std::ostringstream message;
+    message << e;
+    Kolab::Utils::logDiagnostic(Kolab::Diagnostic(Kolab::Error, code, message.str()));
+}
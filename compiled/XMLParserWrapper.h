@@ -34,6 +34,8 @@
 
 #include <xercesc/framework/XMLGrammarPool.hpp>
 
+#include "../src/global_definitions.h"
+
 /**
  * This wrapper controls the lifetime of the parser object.
  * 
@@ -57,10 +59,76 @@ public:
      * Access via singleton to reuse parser.
      */
     static XMLParserWrapper &inst();
+
+    /**
+     * The parser to use for a single parse: the parser of the calling thread (inst()), or, with a pool configured,
+     * a parser checked out of the pool, which is returned to it on destruction.
+     *
+     * The parsed documents are adopted by the caller and don't depend on the parser, so the lease can be a temporary:
+     * XMLParserWrapper::Lease()->parseString(s)
+     */
+    class Lease {
+    public:
+        Lease();
+        ~Lease();
+        XMLParserWrapper *operator->() const { return mParser; }
+    private:
+        Lease(const Lease &);
+        void operator=(const Lease &);
+        XMLParserWrapper *mParser;
+        bool mPooled;
+    };
+
+    /**
+     * Initializes Xerces and loads the grammar pool (which is shared by the parsers of all threads) for the whole process,
+     * and creates a parser for the calling thread and the given number of parsers for threads which haven't used the library yet
+     * (with a pool, the parsers are added to the pool instead).
+     *
+     * All parsers parse the warm-up document once. Calls can be nested, the resources are released by the last shutdown().
+     */
+    static bool initialize(unsigned int parsers, const std::string &warmupDocument);
+    static void shutdown();
+
+    /**
+     * Makes sure Xerces is initialized for the calling thread, so documents can be serialized with xml_schema::flags::dont_initialize
+     * (otherwise the serializer initializes and terminates Xerces on every call).
+     */
+    static void ensureInitialized();
+
+    /**
+     * Creates the document to serialize an object model into (with the generated function taking a DOMDocument),
+     * declaring the namespaces of map on the root element.
+     *
+     * The document is allocated through the library's memory manager, so serializing is accounted like parsing.
+     */
+    static xml_schema::dom::auto_ptr<xercesc::DOMDocument> createDocument(const std::string &rootElement, const std::string &ns, const xml_schema::namespace_infomap &map);
+
+    /**
+     * Writes a document created by createDocument() as UTF-8, throws xml_schema::serialization on failure.
+     */
+    static void writeDocument(std::ostream &os, const xercesc::DOMDocument &doc);
+
+    /**
+     * Replaces the parsers per thread by a pool of at most maxParsers parsers in use at once (0 restores the parsers per thread).
+     *
+     * Parsers idle for longer than idleTimeout milliseconds are released when parsers are checked out or returned,
+     * and by releaseThreadResources() (0 keeps them).
+     */
+    static void setPool(unsigned int maxParsers, unsigned long idleTimeout);
+
+    /**
+     * Releases the parser of the calling thread and the expired idle parsers.
+     */
+    static void releaseThreadResources();
     
     xml_schema::dom::auto_ptr<xercesc::DOMDocument> parseFile(const std::string &url);
     xml_schema::dom::auto_ptr<xercesc::DOMDocument> parseString(const std::string &s);
     xml_schema::dom::auto_ptr<xercesc::DOMDocument> parse(std::istream &ifs, const std::string &name);
+
+    /**
+     * Records an xsd exception as diagnostics (for parsing errors one per schema violation, with line and column).
+     */
+    static void reportException(const xml_schema::exception &e, Kolab::DiagnosticCode code);
 private:
     void init();
     xsd::cxx::tree::error_handler<char> eh;
@@ -71,6 +139,7 @@ private:
     #else
         xercesc::DOMBuilder  *parser;
     #endif
+    //Shared by all parsers, see acquireGrammarPool()
     xercesc::XMLGrammarPool *gp;
 };
 
@@ -23,101 +23,112 @@
 
    René Nyffenegger rene.nyffenegger@adp-gmbh.ch
 
+   This is an altered version for libkolabxml: the codec is table driven and
+   can append directly to an existing buffer.
+
 */
 
 #include "base64.h"
-#include <iostream>
 
-static const std::string base64_chars = 
+static const char base64_chars[] =
              "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
              "abcdefghijklmnopqrstuvwxyz"
              "0123456789+/";
 
-
-static inline bool is_base64(unsigned char c) {
-  return (isalnum(c) || (c == '+') || (c == '/'));
-}
-
-std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len) {
-  std::string ret;
-  int i = 0;
-  int j = 0;
-  unsigned char char_array_3[3];
-  unsigned char char_array_4[4];
-
-  while (in_len--) {
-    char_array_3[i++] = *(bytes_to_encode++);
-    if (i == 3) {
-      char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-      char_array_4[1] = (unsigned char)(((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4));
-      char_array_4[2] = (unsigned char)(((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6));
-      char_array_4[3] = char_array_3[2] & 0x3f;
-
-      for(i = 0; (i <4) ; i++)
-        ret += base64_chars[char_array_4[i]];
-      i = 0;
+/**
+ * Reverse lookup table, 0xff marks characters which are not part of the alphabet.
+ */
+class Base64DecodeTable
+{
+public:
+    Base64DecodeTable()
+    {
+        for (int i = 0; i < 256; i++) {
+            values[i] = 0xff;
+        }
+        for (unsigned char i = 0; i < 64; i++) {
+            values[static_cast<unsigned char>(base64_chars[i])] = i;
+        }
     }
-  }
-
-  if (i)
-  {
-    for(j = i; j < 3; j++)
-      char_array_3[j] = '\0';
+    unsigned char values[256];
+};
 
-    char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-    char_array_4[1] = (unsigned char)(((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4));
-    char_array_4[2] = (unsigned char)(((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6));
-    char_array_4[3] = char_array_3[2] & 0x3f;
+static const Base64DecodeTable decodeTable;
 
-    for (j = 0; (j < i + 1); j++)
-      ret += base64_chars[char_array_4[j]];
-
-    while((i++ < 3))
-      ret += '=';
-
-  }
-
-  return ret;
+void base64_encode_append(std::string &out, unsigned char const* bytes_to_encode, std::size_t in_len)
+{
+    if (!in_len) {
+        return;
+    }
+    std::size_t pos = out.size();
+    out.resize(pos + base64_encoded_size(in_len));
+    char *dest = &out[0] + pos;
+
+    while (in_len >= 3) {
+        *dest++ = base64_chars[(bytes_to_encode[0] & 0xfc) >> 2];
+        *dest++ = base64_chars[((bytes_to_encode[0] & 0x03) << 4) | ((bytes_to_encode[1] & 0xf0) >> 4)];
+        *dest++ = base64_chars[((bytes_to_encode[1] & 0x0f) << 2) | ((bytes_to_encode[2] & 0xc0) >> 6)];
+        *dest++ = base64_chars[bytes_to_encode[2] & 0x3f];
+        bytes_to_encode += 3;
+        in_len -= 3;
+    }
 
+    if (in_len) {
+        const unsigned char second = (in_len > 1) ? bytes_to_encode[1] : 0;
+        *dest++ = base64_chars[(bytes_to_encode[0] & 0xfc) >> 2];
+        *dest++ = base64_chars[((bytes_to_encode[0] & 0x03) << 4) | ((second & 0xf0) >> 4)];
+        *dest++ = (in_len > 1) ? base64_chars[(second & 0x0f) << 2] : '=';
+        *dest++ = '=';
+    }
 }
 
-std::string base64_decode(std::string const& encoded_string) {
-  std::string::size_type in_len = encoded_string.size();
-  int i = 0;
-  int j = 0;
-  int in_ = 0;
-  unsigned char char_array_4[4], char_array_3[3];
+std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len) {
   std::string ret;
+  base64_encode_append(ret, bytes_to_encode, in_len);
+  return ret;
+}
 
-  while (in_len-- && ( encoded_string[in_] != '=') && is_base64(encoded_string[in_])) {
-    char_array_4[i++] = encoded_string[in_]; in_++;
-    if (i ==4) {
-      for (i = 0; i <4; i++)
-        char_array_4[i] = (unsigned char)(base64_chars.find(char_array_4[i]));
-
-      char_array_3[0] = (unsigned char)((char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4));
-      char_array_3[1] = (unsigned char)(((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2));
-      char_array_3[2] = (unsigned char)(((char_array_4[2] & 0x3) << 6) + char_array_4[3]);
-
-      for (i = 0; (i < 3); i++)
-        ret += char_array_3[i];
-      i = 0;
+void base64_decode_append(std::string &out, char const* encoded, std::size_t in_len)
+{
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(encoded);
+    std::size_t valid = 0;
+    while (valid < in_len && decodeTable.values[in[valid]] != 0xff) {
+        valid++;
+    }
+    if (valid < 2) {
+        return;
     }
-  }
-
-  if (i) {
-    for (j = i; j <4; j++)
-      char_array_4[j] = 0;
-
-    for (j = 0; j <4; j++)
-      char_array_4[j] = (unsigned char)(base64_chars.find(char_array_4[j]));
 
-    char_array_3[0] = (unsigned char)((char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4));
-    char_array_3[1] = (unsigned char)(((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2));
-    char_array_3[2] = (unsigned char)(((char_array_4[2] & 0x3) << 6) + char_array_4[3]);
+    std::size_t pos = out.size();
+    out.resize(pos + (valid / 4) * 3 + ((valid % 4) ? (valid % 4) - 1 : 0));
+    char *dest = &out[0] + pos;
+
+    while (valid >= 4) {
+        const unsigned char c0 = decodeTable.values[in[0]];
+        const unsigned char c1 = decodeTable.values[in[1]];
+        const unsigned char c2 = decodeTable.values[in[2]];
+        const unsigned char c3 = decodeTable.values[in[3]];
+        *dest++ = static_cast<char>((c0 << 2) | (c1 >> 4));
+        *dest++ = static_cast<char>(((c1 & 0xf) << 4) | (c2 >> 2));
+        *dest++ = static_cast<char>(((c2 & 0x3) << 6) | c3);
+        in += 4;
+        valid -= 4;
+    }
 
-    for (j = 0; (j < i - 1); j++) ret += char_array_3[j];
-  }
+    //A trailing group of n characters carries n-1 bytes
+    if (valid >= 2) {
+        const unsigned char c0 = decodeTable.values[in[0]];
+        const unsigned char c1 = decodeTable.values[in[1]];
+        *dest++ = static_cast<char>((c0 << 2) | (c1 >> 4));
+        if (valid == 3) {
+            const unsigned char c2 = decodeTable.values[in[2]];
+            *dest++ = static_cast<char>(((c1 & 0xf) << 4) | (c2 >> 2));
+        }
+    }
+}
 
+std::string base64_decode(std::string const& encoded_string) {
+  std::string ret;
+  base64_decode_append(ret, encoded_string.data(), encoded_string.size());
   return ret;
 }
@@ -23,10 +23,38 @@
 
    René Nyffenegger rene.nyffenegger@adp-gmbh.ch
 
+   This is an altered version for libkolabxml: the codec is table driven and
+   can append directly to an existing buffer.
+
 */
 
+#ifndef BASE64_H
+#define BASE64_H
+
 #include <string>
+#include <cstddef>
 
 std::string base64_encode(unsigned char const* , unsigned int len);
 std::string base64_decode(std::string const& s);
 
+/**
+ * Appends the encoded form of the len bytes to out.
+ *
+ * out is grown exactly once, so callers can build i.e. data: uris without intermediate copies.
+ */
+void base64_encode_append(std::string &out, unsigned char const*, std::size_t len);
+
+/**
+ * Appends the decoded form of the len characters to out.
+ *
+ * Decoding stops at the first padding or non-base64 character, like base64_decode.
+ */
+void base64_decode_append(std::string &out, char const*, std::size_t len);
+
+/**
+ * The size of the encoded form of len bytes (including padding).
+ */
+inline std::size_t base64_encoded_size(std::size_t len) { return ((len + 2) / 3) * 4; }
+
+#endif
+
@@ -16,8 +16,43 @@
 */
 
 #include "kolabcontact.h"
+#include "../base64.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 namespace Kolab {
+
+/**
+ * A base64 encoded value which is decoded on first access.
+ *
+ * Copies of a contact share the same instance, so the value is decoded at most once.
+ */
+class LazyBase64Data
+{
+public:
+    explicit LazyBase64Data(const std::string &base64)
+    :   mEncoded(base64),
+        mDecoded(false)
+    {}
+
+    const std::string &data() const
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+        if (!mDecoded) {
+            base64_decode_append(mData, mEncoded.data(), mEncoded.size());
+            std::string().swap(mEncoded);
+            mDecoded = true;
+        }
+        return mData;
+    }
+
+private:
+    mutable boost::mutex mMutex;
+    mutable std::string mEncoded;
+    mutable std::string mData;
+    mutable bool mDecoded;
+};
     
 struct DistList::Private
 {
@@ -156,6 +191,20 @@ struct Contact::Private
     std::vector<Key> keys;
     Crypto crypto;
     std::vector<CustomProperty> customProperties;
+
+    //Binary values which have not been decoded yet
+    boost::shared_ptr<LazyBase64Data> encodedPhoto;
+    struct EncodedLogo {
+        std::size_t index;
+        boost::shared_ptr<LazyBase64Data> logo;
+        std::string mimetype;
+    };
+    std::vector<EncodedLogo> encodedLogos;
+    struct EncodedKey {
+        boost::shared_ptr<LazyBase64Data> key;
+        Key::KeyType type;
+    };
+    std::vector<EncodedKey> encodedKeys;
 };
 
 Contact::Contact()
@@ -274,11 +323,30 @@ std::vector< std::string > Contact::titles() const
 void Contact::setAffiliations(const std::vector< Affiliation > &a)
 {
     d->affiliations = a;
+    d->encodedLogos.clear();
+}
+
+void Contact::setEncodedAffiliationLogo(std::size_t index, const std::string &base64, const std::string &mimetype)
+{
+    Private::EncodedLogo logo;
+    logo.index = index;
+    logo.logo.reset(new LazyBase64Data(base64));
+    logo.mimetype = mimetype;
+    d->encodedLogos.push_back(logo);
 }
 
 std::vector< Affiliation > Contact::affiliations() const
 {
-    return d->affiliations;
+    if (d->encodedLogos.empty()) {
+        return d->affiliations;
+    }
+    std::vector< Affiliation > affiliations = d->affiliations;
+    for (std::vector<Private::EncodedLogo>::const_iterator it = d->encodedLogos.begin(); it != d->encodedLogos.end(); it++) {
+        if (it->index < affiliations.size()) {
+            affiliations[it->index].setLogo(it->logo->data(), it->mimetype);
+        }
+    }
+    return affiliations;
 }
 
 void Contact::setUrls(const std::vector<Url> &urls)
@@ -352,10 +420,21 @@ void Contact::setPhoto(const std::string& data, const std::string& mimetype)
 {
     d->photo = data;
     d->photoMimetype = mimetype;
+    d->encodedPhoto.reset();
+}
+
+void Contact::setEncodedPhoto(const std::string &base64, const std::string &mimetype)
+{
+    d->photo.clear();
+    d->photoMimetype = mimetype;
+    d->encodedPhoto.reset(new LazyBase64Data(base64));
 }
 
 std::string Contact::photo() const
 {
+    if (d->encodedPhoto) {
+        return d->encodedPhoto->data();
+    }
     return d->photo;
 }
 
@@ -445,11 +524,29 @@ std::vector< Geo > Contact::gpsPos() const
 void Contact::setKeys(const std::vector<Key> &keys)
 {
     d->keys = keys;
+    d->encodedKeys.clear();
+}
+
+void Contact::addEncodedKey(const std::string &base64, Key::KeyType type)
+{
+    Private::EncodedKey key;
+    key.key.reset(new LazyBase64Data(base64));
+    key.type = type;
+    d->encodedKeys.push_back(key);
 }
 
 std::vector<Key> Contact::keys() const
 {
-    return d->keys;
+    if (d->encodedKeys.empty()) {
+        return d->keys;
+    }
+    std::vector<Key> keys;
+    keys.reserve(d->keys.size() + d->encodedKeys.size());
+    keys = d->keys;
+    for (std::vector<Private::EncodedKey>::const_iterator it = d->encodedKeys.begin(); it != d->encodedKeys.end(); it++) {
+        keys.push_back(Key(it->key->data(), it->type));
+    }
+    return keys;
 }
 
 void Contact::setCrypto(const Kolab::Crypto& c)
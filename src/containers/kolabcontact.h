@@ -359,6 +359,10 @@ public:
     std::vector<std::string> titles() const;
     
     void setAffiliations(const std::vector<Affiliation> &);
+    /**
+     * Sets the base64 encoded logo of the affiliation at index, which is decoded on access (see setEncodedPhoto).
+     */
+    void setEncodedAffiliationLogo(std::size_t index, const std::string &base64, const std::string &mimetype);
     std::vector<Affiliation> affiliations() const;
     
     void setUrls(const std::vector<Url> &);
@@ -381,6 +385,13 @@ public:
     cDateTime anniversary() const;
     
     void setPhoto(const std::string &data, const std::string &mimetype);
+    /**
+     * Sets the photo in its base64 encoded form.
+     *
+     * The photo is only decoded once it is accessed, so reading contacts (i.e. to list an addressbook)
+     * doesn't pay for photos which are never looked at.
+     */
+    void setEncodedPhoto(const std::string &base64, const std::string &mimetype);
     std::string photo() const;
     std::string photoMimetype() const;
     
@@ -413,6 +424,10 @@ public:
     std::vector<Geo> gpsPos() const;
     
     void setKeys(const std::vector<Key> &);
+    /**
+     * Adds a base64 encoded key, which is decoded on access (see setEncodedPhoto).
+     */
+    void addEncodedKey(const std::string &base64, Key::KeyType);
     std::vector<Key> keys() const;
     
     void setCrypto(const Crypto &);
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2012  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENUMSTRINGS_H
+#define ENUMSTRINGS_H
+
+#include <string>
+#include <cstring>
+#include <cstddef>
+
+namespace Kolab {
+    namespace Shared {
+
+/**
+ * An entry of a table mapping enum values (or flags) to their string representation in the format.
+ *
+ * The tables are statically initialized arrays, so no strings are constructed for a lookup.
+ * Reverse lookups compare the length first, which is all the "hashing" the handful of entries per table needs.
+ *
+ * If a value has several entries (i.e. to accept a legacy spelling), the first one is used for serialization.
+ */
+template <typename T>
+struct EnumString {
+    T value;
+    const char *string;
+    std::size_t length;
+};
+
+/**
+ * Initializes an EnumString from a string literal.
+ */
+#define ENUM_STRING(value, literal) { value, literal, sizeof(literal) - 1 }
+
+/**
+ * Returns the entry for value or 0.
+ */
+template <typename T, std::size_t N>
+const EnumString<T> *findEnumString(const EnumString<T> (&table)[N], T value)
+{
+    for (std::size_t i = 0; i < N; i++) {
+        if (table[i].value == value) {
+            return &table[i];
+        }
+    }
+    return 0;
+}
+
+/**
+ * Returns the entry for the string s or 0.
+ */
+template <typename T, std::size_t N>
+const EnumString<T> *findEnumString(const EnumString<T> (&table)[N], const char *s, std::size_t length)
+{
+    for (std::size_t i = 0; i < N; i++) {
+        if (table[i].length == length && !std::memcmp(table[i].string, s, length)) {
+            return &table[i];
+        }
+    }
+    return 0;
+}
+
+template <typename T, std::size_t N>
+const EnumString<T> *findEnumString(const EnumString<T> (&table)[N], const std::string &s)
+{
+    return findEnumString(table, s.data(), s.size());
+}
+
+/**
+ * Returns the string for value, or an empty string.
+ */
+template <typename T, std::size_t N>
+const char *enumToString(const EnumString<T> (&table)[N], T value)
+{
+    const EnumString<T> *entry = findEnumString(table, value);
+    return entry ? entry->string : "";
+}
+
+/**
+ * Sets value from the string s, returns false (leaving value untouched) if s is unknown.
+ */
+template <typename T, std::size_t N>
+bool enumFromString(const EnumString<T> (&table)[N], const std::string &s, T &value)
+{
+    const EnumString<T> *entry = findEnumString(table, s);
+    if (!entry) {
+        return false;
+    }
+    value = entry->value;
+    return true;
+}
+
+/**
+ * Returns the combination of all flags in the list of strings (unknown strings are ignored).
+ */
+template <typename List, std::size_t N>
+int flagsFromStrings(const EnumString<int> (&table)[N], const List &list)
+{
+    int flags = 0;
+    for (typename List::const_iterator it = list.begin(); it != list.end(); ++it) {
+        const std::string &s = *it;
+        const EnumString<int> *entry = findEnumString(table, s);
+        if (entry) {
+            flags |= entry->value;
+        }
+    }
+    return flags;
+}
+
+/**
+ * Appends the strings of all flags set in flags (in table order) to list.
+ */
+template <typename List, std::size_t N>
+void flagsToStrings(const EnumString<int> (&table)[N], int flags, List &list)
+{
+    for (std::size_t i = 0; i < N; i++) {
+        if (flags & table[i].value) {
+            list.push_back(typename List::value_type(table[i].string));
+        }
+    }
+}
+
+    } //Namespace
+} //Namespace
+
+#endif
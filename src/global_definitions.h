@@ -18,6 +18,8 @@
 #ifndef KOLAB_GLOBAL_DEFINITIONS_H
 #define KOLAB_GLOBAL_DEFINITIONS_H
 
+#include <string>
+
 namespace Kolab {
 
 enum ErrorSeverity {
@@ -27,6 +29,113 @@ enum ErrorSeverity {
     Critical //Ciritcal error, produced object cannot be used and should be thrown away (writing back will result in dataloss).
 };
 
+enum DiagnosticCode {
+    GenericError, //Conversion of a value failed, or any other problem
+    ParseError, //The document is not well-formed or not valid according to the schema
+    SerializationError, //The object could not be written
+    ValidationError, //The object violates a constraint of the format
+    ResourceLimitError //A configured limit (such as the memory budget) was exceeded
+};
+
+/**
+ * A single warning or error which occurred during serialization/deserialization.
+ */
+struct Diagnostic {
+    Diagnostic(): severity(NoError), code(GenericError), line(0), column(0) {};
+    Diagnostic(ErrorSeverity s, DiagnosticCode c, const std::string &m, unsigned long l = 0, unsigned long col = 0)
+    : severity(s), code(c), message(m), line(l), column(col) {};
+    ErrorSeverity severity;
+    DiagnosticCode code;
+    std::string message;
+    //Position in the document if known (starting at 1), otherwise 0
+    unsigned long line;
+    unsigned long column;
+};
+
+enum ObjectType {
+    UnknownObject,
+    EventObject,
+    TodoObject,
+    JournalObject,
+    FreebusyObject,
+    ContactObject,
+    DistlistObject,
+    NoteObject,
+    FileObject,
+    ConfigurationObject
+};
+
+/**
+ * The phases of a read or write.
+ */
+enum Phase {
+    ParsePhase, //XML parsing, including the schema validation (Xerces validates while parsing)
+    BindPhase, //DOM to xsd object model
+    ConvertPhase, //xsd object model to containers (read), or containers to xsd object model (write)
+    ValidatePhase, //Semantic validation of the containers
+    SerializePhase, //xsd object model to XML
+    SelfCheckPhase //Reading back the written document
+};
+
+/**
+ * Aggregated durations of a phase for an object type (in microseconds).
+ */
+struct PhaseStatistics {
+    PhaseStatistics(): type(UnknownObject), phase(ParsePhase), count(0), totalTime(0), maxTime(0) {};
+    ObjectType type;
+    Phase phase;
+    unsigned long count;
+    double totalTime;
+    double maxTime;
+};
+
+/**
+ * Memory allocated through Xerces (the DOM and the parser buffers) during a read or write.
+ */
+struct MemoryStatistics {
+    MemoryStatistics(): allocations(0), allocatedBytes(0), peakBytes(0) {};
+    unsigned long allocations;
+    //Sum of all allocations
+    unsigned long allocatedBytes;
+    //Maximum amount held at once (on top of what was held before the operation)
+    unsigned long peakBytes;
+};
+
+/**
+ * Describes the begin or end of a traced operation.
+ */
+struct TraceInfo {
+    TraceInfo(): operation(""), type(UnknownObject), size(0), result(NoError), duration(0) {};
+    //"read", "write", "selfCheck" (reading back a written document) or "loadGrammar"
+    const char *operation;
+    ObjectType type;
+    //Size of the read or written document, 0 if not known (yet)
+    unsigned long size;
+    //UID of the object, only set at the end of reads and writes
+    std::string uid;
+    //Highest severity of the errors, only set at the end
+    ErrorSeverity result;
+    //Nanoseconds the operation took, only set at the end
+    unsigned long long duration;
+};
+
+/**
+ * Limits for reading untrusted input, 0 means unlimited (the default).
+ */
+struct ResourceLimits {
+    ResourceLimits(): maxInputSize(0), maxElementCount(0), maxAttachmentSize(0), maxExceptions(0), maxTime(0) {};
+    //Size of the document in bytes
+    unsigned long maxInputSize;
+    //Number of XML elements in the document
+    unsigned long maxElementCount;
+    //Decoded size of a single attachment or photo in bytes
+    unsigned long maxAttachmentSize;
+    //Number of exceptions of a recurring event or todo
+    unsigned long maxExceptions;
+    //Wall time of a read or write in milliseconds (checked at element boundaries while parsing and between the incidences)
+    unsigned long maxTime;
+};
+
 }
 
 #endif
@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2012  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "instrumentation.h"
+#include "utils.h"
+#include <boost/thread.hpp>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace Kolab {
+    namespace Utils {
+
+static const int objectTypeCount = ConfigurationObject + 1;
+static const int phaseCount = SelfCheckPhase + 1;
+
+struct PhaseData {
+    unsigned long count;
+    unsigned long long total;
+    unsigned long long max;
+};
+
+//Read and written with atomicAdd, only changed with the registry locked
+static unsigned long enabled = 0;
+TraceHook traceBeginHook = 0;
+TraceHook traceEndHook = 0;
+
+/**
+ * Per thread state, so the phases can be accounted without passing the object type around.
+ *
+ * The statistics are only written by the owning thread, with atomic operations so they can be read by getPhaseStatistics().
+ * They belong to the reset generation they were written in, older ones are ignored and cleared by the owner on the next sample.
+ */
+struct InstrumentationState {
+    InstrumentationState(): type(UnknownObject), selfCheck(0), generation(0) { clearStatistics(); };
+    void clearStatistics()
+    {
+        for (int type = 0; type < objectTypeCount; type++) {
+            for (int phase = 0; phase < phaseCount; phase++) {
+                statistics[type][phase] = PhaseData();
+            }
+        }
+    }
+    ObjectType type;
+    int selfCheck;
+    unsigned long generation;
+    PhaseData statistics[objectTypeCount][phaseCount];
+};
+
+static boost::mutex registryMutex;
+static const bool registryMutexProtected = protectAcrossFork(registryMutex);
+//The states of the running threads
+static std::vector<InstrumentationState*> states;
+//The statistics of the exited threads (since the last reset)
+static PhaseData retired[objectTypeCount][phaseCount];
+//Incremented by resetPhaseStatistics() (with the registry locked)
+static unsigned long currentGeneration = 0;
+
+static void merge(PhaseData &to, unsigned long count, unsigned long long total, unsigned long long max)
+{
+    to.count += count;
+    to.total += total;
+    if (max > to.max) {
+        to.max = max;
+    }
+}
+
+static void retireState(InstrumentationState *s)
+{
+    boost::mutex::scoped_lock lock(registryMutex);
+    if (s->generation == currentGeneration) {
+        for (int type = 0; type < objectTypeCount; type++) {
+            for (int phase = 0; phase < phaseCount; phase++) {
+                const PhaseData &data = s->statistics[type][phase];
+                merge(retired[type][phase], data.count, data.total, data.max);
+            }
+        }
+    }
+    states.erase(std::remove(states.begin(), states.end(), s), states.end());
+    delete s;
+}
+
+static boost::thread_specific_ptr<InstrumentationState> statePtr(&retireState);
+
+static InstrumentationState &state()
+{
+    InstrumentationState *s = statePtr.get();
+    if (!s) {
+        s = new InstrumentationState();
+        boost::mutex::scoped_lock lock(registryMutex);
+        s->generation = currentGeneration;
+        states.push_back(s);
+        statePtr.reset(s);
+    }
+    return *s;
+}
+
+static inline bool isEnabled()
+{
+    return atomicAdd(enabled, 0);
+}
+
+unsigned long long monotonicTime()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    const unsigned long long ticks = static_cast<unsigned long long>(counter.QuadPart);
+    const unsigned long long perSecond = static_cast<unsigned long long>(frequency.QuadPart);
+    //Split up to avoid overflowing the nanoseconds
+    return ticks / perSecond * 1000000000ull + ticks % perSecond * 1000000000ull / perSecond;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long long>(ts.tv_sec) * 1000000000ull + static_cast<unsigned long long>(ts.tv_nsec);
+#endif
+}
+
+void setInstrumentationEnabled(bool e)
+{
+    boost::mutex::scoped_lock lock(registryMutex);
+    const unsigned long value = e ? 1 : 0;
+    atomicAdd(enabled, value - atomicAdd(enabled, 0));
+}
+
+bool instrumentationEnabled()
+{
+    return isEnabled();
+}
+
+std::vector<PhaseStatistics> getPhaseStatistics()
+{
+    PhaseData statistics[objectTypeCount][phaseCount];
+    {
+        boost::mutex::scoped_lock lock(registryMutex);
+        std::copy(&retired[0][0], &retired[0][0] + objectTypeCount * phaseCount, &statistics[0][0]);
+        for (std::vector<InstrumentationState*>::const_iterator it = states.begin(); it != states.end(); ++it) {
+            if (atomicAdd((*it)->generation, 0) != currentGeneration) {
+                continue;
+            }
+            for (int type = 0; type < objectTypeCount; type++) {
+                for (int phase = 0; phase < phaseCount; phase++) {
+                    PhaseData &data = (*it)->statistics[type][phase];
+                    merge(statistics[type][phase], atomicAdd(data.count, 0), atomicAdd(data.total, 0), atomicAdd(data.max, 0));
+                }
+            }
+        }
+    }
+    std::vector<PhaseStatistics> result;
+    for (int type = 0; type < objectTypeCount; type++) {
+        for (int phase = 0; phase < phaseCount; phase++) {
+            const PhaseData &data = statistics[type][phase];
+            if (!data.count) {
+                continue;
+            }
+            PhaseStatistics s;
+            s.type = static_cast<ObjectType>(type);
+            s.phase = static_cast<Phase>(phase);
+            s.count = data.count;
+            s.totalTime = static_cast<double>(data.total) / 1000.0;
+            s.maxTime = static_cast<double>(data.max) / 1000.0;
+            result.push_back(s);
+        }
+    }
+    return result;
+}
+
+void resetPhaseStatistics()
+{
+    boost::mutex::scoped_lock lock(registryMutex);
+    std::fill(&retired[0][0], &retired[0][0] + objectTypeCount * phaseCount, PhaseData());
+    //The running threads clear their statistics on the next sample
+    atomicAdd(currentGeneration, 1);
+}
+
+ObjectTypeScope::ObjectTypeScope(ObjectType type)
+:   mActive(isEnabled()),
+    mPrevious(UnknownObject)
+{
+    if (mActive) {
+        InstrumentationState &s = state();
+        mPrevious = s.type;
+        s.type = type;
+    }
+}
+
+ObjectTypeScope::~ObjectTypeScope()
+{
+    if (mActive) {
+        state().type = mPrevious;
+    }
+}
+
+PhaseTimer::PhaseTimer(Phase phase)
+:   mActive(false),
+    mPhase(phase),
+    mStart(0)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    InstrumentationState &s = state();
+    if (s.selfCheck) {
+        return;
+    }
+    if (phase == SelfCheckPhase) {
+        s.selfCheck++;
+    }
+    mActive = true;
+    mStart = monotonicTime();
+}
+
+PhaseTimer::~PhaseTimer()
+{
+    stop();
+}
+
+void PhaseTimer::stop()
+{
+    if (!mActive) {
+        return;
+    }
+    mActive = false;
+    const unsigned long long duration = monotonicTime() - mStart;
+    InstrumentationState &s = state();
+    if (mPhase == SelfCheckPhase) {
+        s.selfCheck--;
+    }
+    const unsigned long generation = atomicAdd(currentGeneration, 0);
+    if (s.generation != generation) {
+        //Not read by getPhaseStatistics() until the generation is updated
+        s.clearStatistics();
+        atomicAdd(s.generation, generation - s.generation);
+    }
+    //Only this thread writes, the reads of the own values don't need to be atomic
+    PhaseData &data = s.statistics[s.type][mPhase];
+    atomicAdd(data.count, 1);
+    atomicAdd(data.total, duration);
+    if (duration > data.max) {
+        atomicAdd(data.max, duration - data.max);
+    }
+}
+
+void setTracer(TraceHook begin, TraceHook end)
+{
+    traceBeginHook = begin;
+    traceEndHook = end;
+}
+
+void TraceScope::begin()
+{
+    TraceHook hook = traceBeginHook;
+    if (!hook) {
+        return;
+    }
+    TraceInfo info;
+    info.operation = mOperation;
+    info.type = mType;
+    info.size = mSize;
+    info.uid = mUid;
+    hook(info);
+}
+
+void TraceScope::setCreatedUid()
+{
+    if (mEnd) {
+        mUid = createdUid();
+    }
+}
+
+void TraceScope::end()
+{
+    TraceInfo info;
+    info.operation = mOperation;
+    info.type = mType;
+    info.size = mSize;
+    info.uid = mUid;
+    info.result = getError();
+    info.duration = monotonicTime() - mStart;
+    mEnd(info);
+}
+
+void DeferredTrace::end()
+{
+    if (!mStart) {
+        return;
+    }
+    mInfo.result = getError();
+    mInfo.duration = monotonicTime() - mStart;
+    mEnded = true;
+}
+
+void DeferredTrace::report()
+{
+    //The begin info doesn't contain the outcome yet
+    TraceHook begin = traceBeginHook;
+    if (begin) {
+        TraceInfo info;
+        info.operation = mInfo.operation;
+        info.type = mInfo.type;
+        info.size = mInfo.size;
+        begin(info);
+    }
+    if (mEnd) {
+        mEnd(mInfo);
+    }
+}
+
+    }
+}
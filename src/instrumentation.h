@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2012  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include "global_definitions.h"
+
+namespace Kolab {
+    namespace Utils {
+
+/**
+ * Optional timing of the phases of reads and writes.
+ *
+ * Disabled by default, in which case the scopes below cost a check of a global flag.
+ * The statistics are process-wide, they are accumulated per thread and merged by getPhaseStatistics().
+ */
+void setInstrumentationEnabled(bool);
+bool instrumentationEnabled();
+std::vector<PhaseStatistics> getPhaseStatistics();
+void resetPhaseStatistics();
+
+/**
+ * Nanoseconds from a monotonic clock.
+ */
+unsigned long long monotonicTime();
+
+/**
+ * Sets the object type the phases of the calling thread are accounted to.
+ */
+class ObjectTypeScope
+{
+public:
+    explicit ObjectTypeScope(ObjectType);
+    ~ObjectTypeScope();
+private:
+    ObjectTypeScope(const ObjectTypeScope &);
+    ObjectTypeScope &operator=(const ObjectTypeScope &);
+    bool mActive;
+    ObjectType mPrevious;
+};
+
+/**
+ * Measures a phase until it is stopped or goes out of scope.
+ *
+ * Phases nested in the self-check of a write are accounted to the self-check only.
+ */
+class PhaseTimer
+{
+public:
+    explicit PhaseTimer(Phase);
+    ~PhaseTimer();
+    void stop();
+private:
+    PhaseTimer(const PhaseTimer &);
+    PhaseTimer &operator=(const PhaseTimer &);
+    bool mActive;
+    Phase mPhase;
+    unsigned long long mStart;
+};
+
+typedef void (*TraceHook)(const TraceInfo &);
+void setTracer(TraceHook begin, TraceHook end);
+
+//The installed hooks, only to be used by TraceScope
+extern TraceHook traceBeginHook;
+extern TraceHook traceEndHook;
+
+/**
+ * Reports the begin and end of an operation to the installed tracer.
+ *
+ * Without a tracer this costs a single branch on construction and destruction.
+ */
+class TraceScope
+{
+public:
+    TraceScope(const char *operation, ObjectType type, std::size_t size = 0)
+    :   mEnd(traceEndHook),
+        mOperation(operation),
+        mType(type),
+        mSize(size),
+        mStart(mEnd ? monotonicTime() : 0)
+    {
+        if (traceBeginHook) {
+            begin();
+        }
+    }
+
+    /**
+     * For operations on an object whose UID is already known at the begin (the self-check of a write).
+     */
+    TraceScope(const char *operation, ObjectType type, std::size_t size, const std::string &uid)
+    :   mEnd(traceEndHook),
+        mOperation(operation),
+        mType(type),
+        mSize(size),
+        mStart(mEnd ? monotonicTime() : 0)
+    {
+        if (mEnd || traceBeginHook) {
+            mUid = uid;
+        }
+        if (traceBeginHook) {
+            begin();
+        }
+    }
+
+    ~TraceScope()
+    {
+        if (mEnd) {
+            end();
+        }
+    }
+
+    void setSize(std::size_t size)
+    {
+        mSize = size;
+    }
+
+    /**
+     * Takes the UID of object, it is only retrieved while tracing.
+     */
+    template <typename T>
+    void setObject(const T &object)
+    {
+        if (mEnd) {
+            mUid = object.uid();
+        }
+    }
+
+    /**
+     * Takes the UID of the object just written (which may have been generated), it is only retrieved while tracing.
+     */
+    void setCreatedUid();
+
+    const std::string &uid() const
+    {
+        return mUid;
+    }
+
+private:
+    TraceScope(const TraceScope &);
+    TraceScope &operator=(const TraceScope &);
+    void begin();
+    void end();
+    //The end hook at the begin, so a tracer installed during the operation doesn't get an end without begin
+    TraceHook mEnd;
+    const char *mOperation;
+    ObjectType mType;
+    std::size_t mSize;
+    std::string mUid;
+    unsigned long long mStart;
+};
+
+/**
+ * Reports an operation which runs while a lock is held (the loading of the grammar): begin() and end() only record it,
+ * and the hooks are called on destruction. Declared before the lock, so the hooks run once it is released and a hook
+ * calling back into the library can't deadlock, nor can a slow hook block the other threads.
+ */
+class DeferredTrace
+{
+public:
+    DeferredTrace()
+    :   mEnd(0),
+        mStart(0),
+        mEnded(false)
+    {
+    }
+
+    ~DeferredTrace()
+    {
+        if (mEnded) {
+            report();
+        }
+    }
+
+    void begin(const char *operation, ObjectType type, std::size_t size)
+    {
+        mEnd = traceEndHook;
+        if (!mEnd && !traceBeginHook) {
+            return;
+        }
+        mInfo.operation = operation;
+        mInfo.type = type;
+        mInfo.size = size;
+        mStart = monotonicTime();
+    }
+
+    void end();
+private:
+    DeferredTrace(const DeferredTrace &);
+    DeferredTrace &operator=(const DeferredTrace &);
+    void report();
+    TraceHook mEnd;
+    TraceInfo mInfo;
+    unsigned long long mStart;
+    bool mEnded;
+};
+
+    }
+}
+
+#endif
@@ -72,6 +72,9 @@ Kolab::Attachment toAttachment(KolabXSD::attachmentPropType aProp)
     if (aProp.uri()) {
         a.setUri(*aProp.uri(), mimetype);
     } else if (aProp.binary()) {
+        if (Utils::exceedsAttachmentSize(aProp.binary()->size() / 4 * 3)) {
+            throw Utils::ResourceLimitExceeded();
+        }
         a.setData(base64_decode(*aProp.binary()), mimetype);
     } else {
         ERROR("not uri and no data available");
@@ -103,30 +106,70 @@ KolabXSD::attachmentPropType fromAttachment(const Kolab::Attachment &a)
 
 void writeColors(KolabXSD::Configuration::categorycolor_sequence &colors, const std::vector<CategoryColor> &input)
 {
+    //Fill the entries in place, copying a finished entry into the sequence would copy its whole subtree on every level
     BOOST_FOREACH (const CategoryColor &entry, input) {
-        KolabXSD::Configuration::categorycolor_type c(entry.category());
+        colors.push_back(KolabXSD::Configuration::categorycolor_type(entry.category()));
+        KolabXSD::Configuration::categorycolor_type &c = colors.back();
         c.color(entry.color());
         writeColors(c.categorycolor(), entry.subcategories());
-        colors.push_back(c);
     }
 }
 
 std::vector<CategoryColor> readColors(const KolabXSD::Configuration::categorycolor_sequence &list)
 {
-    std::vector<CategoryColor> colors ;
+    std::vector<CategoryColor> colors;
+    colors.reserve(list.size());
     BOOST_FOREACH (const KolabXSD::Configuration::categorycolor_type &entry, list) {
         if (!entry.color()) {
             ERROR("Color is missing");
             continue;
         }
-        CategoryColor color(entry.category());
+        colors.push_back(CategoryColor(entry.category()));
+        CategoryColor &color = colors.back();
         color.setColor(*entry.color());
-        color.setSubcategories(readColors(entry.categorycolor()));
-        colors.push_back(color);
+        if (!entry.categorycolor().empty()) {
+            color.setSubcategories(readColors(entry.categorycolor()));
+        }
     }
     return colors;
 }
 
+//Note and File share the classification type
+const Kolab::Classification classifications[] = {
+    Kolab::ClassPublic,
+    Kolab::ClassPrivate,
+    Kolab::ClassConfidential
+};
+const KolabXSD::classifcationPropType::value xsdClassifications[] = {
+    KolabXSD::classifcationPropType::PUBLIC,
+    KolabXSD::classifcationPropType::PRIVATE,
+    KolabXSD::classifcationPropType::CONFIDENTIAL
+};
+
+template <typename T>
+void setClassification(T &object, Kolab::Classification classification)
+{
+    for (std::size_t i = 0; i < sizeof(classifications) / sizeof(classifications[0]); i++) {
+        if (classifications[i] == classification) {
+            object.classification(xsdClassifications[i]);
+            return;
+        }
+    }
+    ERROR("unknown classification");
+}
+
+template <typename T>
+void getClassification(const T &object, Kolab::Classification &classification)
+{
+    for (std::size_t i = 0; i < sizeof(xsdClassifications) / sizeof(xsdClassifications[0]); i++) {
+        if (xsdClassifications[i] == *object.classification()) {
+            classification = classifications[i];
+            return;
+        }
+    }
+    ERROR("unknown classification");
+}
+
 KolabXSD::Configuration::type_type getConfigurationType(Kolab::Configuration::ConfigurationType t)
 {
     switch (t) {
@@ -154,21 +197,23 @@ template <>
 std::string serializeObject <Kolab::Configuration> (const Kolab::Configuration &configuration, const std::string prod)
 {
     try {
+        Utils::PhaseTimer convertTimer(ConvertPhase);
         const std::string &uid = getUID(configuration.uid());
         setCreatedUid(uid);
 
+        const cDateTime now = (configuration.created().isValid() && configuration.lastModified().isValid()) ? cDateTime() : timestamp();
         KolabXSD::Configuration::creation_date_type created(0,0,0,0,0,0);
         if (configuration.created().isValid()) {
             created = fromDateTime(configuration.created());
         } else {
-            created = fromDateTime(timestamp());
+            created = fromDateTime(now);
         }
         KolabXSD::Configuration::last_modification_date_type lastModificationDate(0,0,0,0,0,0);
         if (configuration.lastModified().isValid()) {
             lastModificationDate = fromDateTime(configuration.lastModified());
         } else {
 //             WARNING("missing last_modification_date, fallback to current timestamp");
-            lastModificationDate = fromDateTime(timestamp());
+            lastModificationDate = fromDateTime(now);
         }
         KolabXSD::Configuration n(uid, getProductId(prod), created, lastModificationDate, getConfigurationType(configuration.type()));
 
@@ -245,11 +290,16 @@ std::string serializeObject <Kolab::Configuration> (const Kolab::Configuration &
         xml_schema::namespace_infomap map;
         map[""].name = KOLAB_NAMESPACE;
 
+        convertTimer.stop();
+        Utils::PhaseTimer serializeTimer(SerializePhase);
         std::ostringstream ostringstream;
-        KolabXSD::configuration(ostringstream, n, map);
+        XMLParserWrapper::ensureInitialized();
+        xml_schema::dom::auto_ptr<xercesc::DOMDocument> document(XMLParserWrapper::createDocument("configuration", KOLAB_NAMESPACE, map));
+        KolabXSD::configuration(*document, n, xml_schema::flags::dont_initialize);
+        XMLParserWrapper::writeDocument(ostringstream, *document);
         return ostringstream.str();
     } catch  (const xml_schema::exception& e) {
-        std::cerr <<  e << std::endl;
+        XMLParserWrapper::reportException(e, Kolab::SerializationError);
     } catch (...) {
         CRITICAL("Unhandled exception");
     }
@@ -261,21 +311,23 @@ template <>
 std::string serializeObject <Kolab::Note> (const Kolab::Note &note, const std::string prod)
 {
     try {
+        Utils::PhaseTimer convertTimer(ConvertPhase);
         const std::string &uid = getUID(note.uid());
         setCreatedUid(uid);
         
+        const cDateTime now = (note.created().isValid() && note.lastModified().isValid()) ? cDateTime() : timestamp();
         KolabXSD::Note::creation_date_type created(0,0,0,0,0,0);
         if (note.created().isValid()) {
             created = fromDateTime(note.created());
         } else {
-            created = fromDateTime(timestamp());
+            created = fromDateTime(now);
         }
         KolabXSD::Note::last_modification_date_type lastModificationDate(0,0,0,0,0,0);
         if (note.lastModified().isValid()) {
             lastModificationDate = fromDateTime(note.lastModified());
         } else {
 //             WARNING("missing last_modification_date, fallback to current timestamp");
-            lastModificationDate = fromDateTime(timestamp());
+            lastModificationDate = fromDateTime(now);
         }
 
         KolabXSD::Note n(uid, getProductId(prod), created, lastModificationDate);
@@ -288,19 +340,7 @@ std::string serializeObject <Kolab::Note> (const Kolab::Note &note, const std::s
             }
             n.categories(categories);
         }
-        switch (note.classification()) {
-            case Kolab::ClassPublic:
-                n.classification(KolabXSD::Note::classification_type::PUBLIC);
-                break;
-            case Kolab::ClassPrivate:
-                n.classification(KolabXSD::Note::classification_type::PRIVATE);
-                break;
-            case Kolab::ClassConfidential:
-                n.classification(KolabXSD::Note::classification_type::CONFIDENTIAL);
-                break;
-            default:
-                ERROR("unknown classification");
-        }
+        setClassification(n, note.classification());
         
         if (!note.attachments().empty()) {
             const std::vector<Kolab::Attachment> &l = note.attachments();
@@ -322,11 +362,16 @@ std::string serializeObject <Kolab::Note> (const Kolab::Note &note, const std::s
         xml_schema::namespace_infomap map;
         map[""].name = KOLAB_NAMESPACE;
 
+        convertTimer.stop();
+        Utils::PhaseTimer serializeTimer(SerializePhase);
         std::ostringstream ostringstream;
-        KolabXSD::note(ostringstream, n, map);
+        XMLParserWrapper::ensureInitialized();
+        xml_schema::dom::auto_ptr<xercesc::DOMDocument> document(XMLParserWrapper::createDocument("note", KOLAB_NAMESPACE, map));
+        KolabXSD::note(*document, n, xml_schema::flags::dont_initialize);
+        XMLParserWrapper::writeDocument(ostringstream, *document);
         return ostringstream.str();
     } catch  (const xml_schema::exception& e) {
-        std::cerr <<  e << std::endl;
+        XMLParserWrapper::reportException(e, Kolab::SerializationError);
     } catch (...) {
         CRITICAL("Unhandled exception");
     }
@@ -338,21 +383,23 @@ template <>
 std::string serializeObject <Kolab::File> (const Kolab::File &file, const std::string prod)
 {
     try {
+        Utils::PhaseTimer convertTimer(ConvertPhase);
         const std::string &uid = getUID(file.uid());
         setCreatedUid(uid);
         
+        const cDateTime now = (file.created().isValid() && file.lastModified().isValid()) ? cDateTime() : timestamp();
         KolabXSD::File::creation_date_type created(0,0,0,0,0,0);
         if (file.created().isValid()) {
             created = fromDateTime(file.created());
         } else {
-            created = fromDateTime(timestamp());
+            created = fromDateTime(now);
         }
         KolabXSD::File::last_modification_date_type lastModificationDate(0,0,0,0,0,0);
         if (file.lastModified().isValid()) {
             lastModificationDate = fromDateTime(file.lastModified());
         } else {
 //             WARNING("missing last_modification_date, fallback to current timestamp");
-            lastModificationDate = fromDateTime(timestamp());
+            lastModificationDate = fromDateTime(now);
         }
         if (file.file().label().empty()) {
             ERROR("missing filename");
@@ -368,19 +415,7 @@ std::string serializeObject <Kolab::File> (const Kolab::File &file, const std::s
             }
             n.categories(categories);
         }
-        switch (file.classification()) {
-            case Kolab::ClassPublic:
-                n.classification(KolabXSD::File::classification_type::PUBLIC);
-                break;
-            case Kolab::ClassPrivate:
-                n.classification(KolabXSD::File::classification_type::PRIVATE);
-                break;
-            case Kolab::ClassConfidential:
-                n.classification(KolabXSD::File::classification_type::CONFIDENTIAL);
-                break;
-            default:
-                ERROR("unknown classification");
-        }
+        setClassification(n, file.classification());
         
         n.note(file.note());
 
@@ -394,11 +429,16 @@ std::string serializeObject <Kolab::File> (const Kolab::File &file, const std::s
         xml_schema::namespace_infomap map;
         map[""].name = KOLAB_NAMESPACE;
 
+        convertTimer.stop();
+        Utils::PhaseTimer serializeTimer(SerializePhase);
         std::ostringstream ostringstream;
-        KolabXSD::file(ostringstream, n, map);
+        XMLParserWrapper::ensureInitialized();
+        xml_schema::dom::auto_ptr<xercesc::DOMDocument> document(XMLParserWrapper::createDocument("file", KOLAB_NAMESPACE, map));
+        KolabXSD::file(*document, n, xml_schema::flags::dont_initialize);
+        XMLParserWrapper::writeDocument(ostringstream, *document);
         return ostringstream.str();
     } catch  (const xml_schema::exception& e) {
-        std::cerr <<  e << std::endl;
+        XMLParserWrapper::reportException(e, Kolab::SerializationError);
     } catch (...) {
         CRITICAL("Unhandled exception");
     }
@@ -415,13 +455,15 @@ boost::shared_ptr<Kolab::Note> deserializeObject <Kolab::Note> (const std::strin
     try {
         std::auto_ptr<KolabXSD::Note> note;
         if (isUrl) {
-            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::inst().parseFile(s);
+            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::Lease()->parseFile(s);
             if (doc.get()) {
+                Utils::PhaseTimer timer(BindPhase);
                 note = KolabXSD::note(doc);
             }
         } else {
-            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::inst().parseString(s);
+            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::Lease()->parseString(s);
             if (doc.get()) {
+                Utils::PhaseTimer timer(BindPhase);
                 note = KolabXSD::note(doc);
             }
         }
@@ -431,6 +473,8 @@ boost::shared_ptr<Kolab::Note> deserializeObject <Kolab::Note> (const std::strin
             return boost::shared_ptr<Kolab::Note>();
         }
 
+        Utils::PhaseTimer convertTimer(ConvertPhase);
+
         boost::shared_ptr<Kolab::Note> n = boost::shared_ptr<Kolab::Note>(new Kolab::Note);
         n->setUid(note->uid());
         n->setCreated(*toDate(note->creation_date()));
@@ -439,19 +483,9 @@ boost::shared_ptr<Kolab::Note> deserializeObject <Kolab::Note> (const std::strin
         std::copy(note->categories().begin(), note->categories().end(), std::back_inserter(categories));
         n->setCategories(categories);
         if (note->classification()) {
-            switch (*note->classification()) {
-                case KolabXSD::Note::classification_type::PUBLIC:
-                    n->setClassification(Kolab::ClassPublic);
-                    break;
-                case KolabXSD::Note::classification_type::PRIVATE:
-                    n->setClassification(Kolab::ClassPrivate);
-                    break;
-                case KolabXSD::Note::classification_type::CONFIDENTIAL:
-                    n->setClassification(Kolab::ClassConfidential);
-                    break;
-                default:
-                    ERROR("unknown classification");
-            }
+            Kolab::Classification classification = Kolab::ClassPublic;
+            getClassification(*note, classification);
+            n->setClassification(classification);
         }
 
         if (!note->attachment().empty()) {
@@ -491,7 +525,10 @@ boost::shared_ptr<Kolab::Note> deserializeObject <Kolab::Note> (const std::strin
         }
         return n;
     } catch  (const xml_schema::exception& e) {
-        std::cerr <<  e << std::endl;
+        XMLParserWrapper::reportException(e, Kolab::ParseError);
+    } catch (const Utils::ResourceLimitExceeded &) {
+        //Already reported
+        return boost::shared_ptr<Kolab::Note>();
     } catch (...) {
         CRITICAL("Unhandled exception");
     }
@@ -507,13 +544,15 @@ boost::shared_ptr<Kolab::Configuration> deserializeObject <Kolab::Configuration>
     try {
         std::auto_ptr<KolabXSD::Configuration> configuration;
         if (isUrl) {
-            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::inst().parseFile(s);
+            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::Lease()->parseFile(s);
             if (doc.get()) {
+                Utils::PhaseTimer timer(BindPhase);
                 configuration = KolabXSD::configuration(doc);
             }
         } else {
-            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::inst().parseString(s);
+            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::Lease()->parseString(s);
             if (doc.get()) {
+                Utils::PhaseTimer timer(BindPhase);
                 configuration = KolabXSD::configuration(doc);
             }
         }
@@ -523,6 +562,8 @@ boost::shared_ptr<Kolab::Configuration> deserializeObject <Kolab::Configuration>
             return boost::shared_ptr<Kolab::Configuration>();
         }
 
+        Utils::PhaseTimer convertTimer(ConvertPhase);
+
         boost::shared_ptr<Kolab::Configuration> n;
         if (configuration->type() == KolabXSD::ConfigurationType::dictionary) {
             std::string lang("XX");
@@ -623,7 +664,10 @@ boost::shared_ptr<Kolab::Configuration> deserializeObject <Kolab::Configuration>
         setKolabVersion( configuration->version() );
         return n;
     } catch  (const xml_schema::exception& e) {
-        std::cerr <<  e << std::endl;
+        XMLParserWrapper::reportException(e, Kolab::ParseError);
+    } catch (const Utils::ResourceLimitExceeded &) {
+        //Already reported
+        return boost::shared_ptr<Kolab::Configuration>();
     } catch (...) {
         CRITICAL("Unhandled exception");
     }
@@ -637,13 +681,15 @@ boost::shared_ptr<Kolab::File> deserializeObject <Kolab::File> (const std::strin
     try {
         std::auto_ptr<KolabXSD::File> file;
         if (isUrl) {
-            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::inst().parseFile(s);
+            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::Lease()->parseFile(s);
             if (doc.get()) {
+                Utils::PhaseTimer timer(BindPhase);
                 file = KolabXSD::file(doc);
             }
         } else {
-            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::inst().parseString(s);
+            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::Lease()->parseString(s);
             if (doc.get()) {
+                Utils::PhaseTimer timer(BindPhase);
                 file = KolabXSD::file(doc);
             }
         }
@@ -653,6 +699,8 @@ boost::shared_ptr<Kolab::File> deserializeObject <Kolab::File> (const std::strin
             return boost::shared_ptr<Kolab::File>();
         }
 
+        Utils::PhaseTimer convertTimer(ConvertPhase);
+
         boost::shared_ptr<Kolab::File> n = boost::shared_ptr<Kolab::File>(new Kolab::File);
         n->setUid(file->uid());
         n->setCreated(*toDate(file->creation_date()));
@@ -661,19 +709,9 @@ boost::shared_ptr<Kolab::File> deserializeObject <Kolab::File> (const std::strin
         std::copy(file->categories().begin(), file->categories().end(), std::back_inserter(categories));
         n->setCategories(categories);
         if (file->classification()) {
-            switch (*file->classification()) {
-                case KolabXSD::File::classification_type::PUBLIC:
-                    n->setClassification(Kolab::ClassPublic);
-                    break;
-                case KolabXSD::File::classification_type::PRIVATE:
-                    n->setClassification(Kolab::ClassPrivate);
-                    break;
-                case KolabXSD::File::classification_type::CONFIDENTIAL:
-                    n->setClassification(Kolab::ClassConfidential);
-                    break;
-                default:
-                    ERROR("unknown classification");
-            }
+            Kolab::Classification classification = Kolab::ClassPublic;
+            getClassification(*file, classification);
+            n->setClassification(classification);
         }
 
         const Kolab::Attachment &attachment = toAttachment(file->file());
@@ -703,7 +741,10 @@ boost::shared_ptr<Kolab::File> deserializeObject <Kolab::File> (const std::strin
         }
         return n;
     } catch  (const xml_schema::exception& e) {
-        std::cerr <<  e << std::endl;
+        XMLParserWrapper::reportException(e, Kolab::ParseError);
+    } catch (const Utils::ResourceLimitExceeded &) {
+        //Already reported
+        return boost::shared_ptr<Kolab::File>();
     } catch (...) {
         CRITICAL("Unhandled exception");
     }
@@ -24,8 +24,44 @@
 #include "utils.h"
 #include "kolabconversions.h"
 #include "objectvalidation.h"
+#include "instrumentation.h"
+#include "metrics.h"
+#include "memoryaccounting.h"
+#include "resourcelimits.h"
 
 namespace Kolab {
+
+bool initialize(unsigned int threads)
+{
+    //A small document to warm up the parsers with (without touching the serialized uid of the calling thread)
+    Kolab::Event event;
+    event.setUid("warmup");
+    event.setCreated(cDateTime(2012,1,1,12,0,0,true));
+    event.setLastModified(cDateTime(2012,1,1,12,0,0,true));
+    event.setStart(cDateTime(2012,1,1,12,0,0,true));
+    const std::string uid = Utils::createdUid();
+    const std::string document = XCAL::serializeIncidence< XCAL::IncidenceTrait<Kolab::Event> >(event);
+    Utils::setCreatedUid(uid);
+
+    const bool result = XMLParserWrapper::initialize(threads, document);
+    Utils::clearErrors();
+    return result;
+}
+
+void shutdown()
+{
+    XMLParserWrapper::shutdown();
+}
+
+void setParserPool(unsigned int maxParsers, unsigned long idleTimeout)
+{
+    XMLParserWrapper::setPool(maxParsers, idleTimeout);
+}
+
+void releaseThreadResources()
+{
+    XMLParserWrapper::releaseThreadResources();
+}
     
 ErrorSeverity error()
 {
@@ -42,6 +78,76 @@ std::string errorMessage()
     return Utils::getErrorMessage();
 }
 
+std::vector<Diagnostic> diagnostics()
+{
+    return Utils::getDiagnostics();
+}
+
+void setInstrumentationEnabled(bool enabled)
+{
+    Utils::setInstrumentationEnabled(enabled);
+}
+
+std::vector<PhaseStatistics> phaseStatistics()
+{
+    return Utils::getPhaseStatistics();
+}
+
+void resetPhaseStatistics()
+{
+    Utils::resetPhaseStatistics();
+}
+
+void setMemoryAccountingEnabled(bool enabled)
+{
+    Utils::setMemoryAccountingEnabled(enabled);
+}
+
+MemoryStatistics lastOperationMemory()
+{
+    return Utils::getLastOperationMemory();
+}
+
+unsigned long threadPeakMemory()
+{
+    return Utils::getThreadPeakMemory();
+}
+
+void setMemoryBudget(unsigned long bytes)
+{
+    Utils::setMemoryBudget(bytes);
+}
+
+void setTracer(TraceHook begin, TraceHook end)
+{
+    Utils::setTracer(begin, end);
+}
+
+void setResourceLimits(const ResourceLimits &limits)
+{
+    Utils::setResourceLimits(limits);
+}
+
+ResourceLimits resourceLimits()
+{
+    return Utils::getResourceLimits();
+}
+
+void setLogHandler(LogHandler handler)
+{
+    Utils::setLogHandler(handler);
+}
+
+void defaultLogHandler(ErrorSeverity severity, const std::string &message)
+{
+    Utils::defaultLogHandler(severity, message);
+}
+
+void setLogThreshold(ErrorSeverity threshold)
+{
+    Utils::setLogThreshold(threshold);
+}
+
 std::string productId()
 {
     return Utils::productId();
@@ -67,223 +173,450 @@ std::string generateUID()
     return Utils::getUID();
 }
 
+std::vector<std::string> generateUIDs(int count)
+{
+    return Utils::getUIDs(count);
+}
+
 void overrideTimestamp(const cDateTime& dt)
 {
     Utils::setOverrideTimestamp(dt);
 }
 
+void setTimestampProvider(TimestampProvider provider)
+{
+    Utils::setTimestampProvider(provider);
+}
+
 Kolab::Event readEvent(const std::string& s, bool isUrl)
+{
+    return readEvent(s, isUrl, 0);
+}
+
+Kolab::Event readEvent(const std::string& s, bool isUrl, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::ReadOperation, EventObject, isUrl ? 0 : s.size());
     Kolab::XCAL::IncidenceTrait <Kolab::Event >::IncidencePtr ptr = XCAL::deserializeIncidence< XCAL::IncidenceTrait<Kolab::Event> >(s, isUrl);
-    if (!ptr.get()) {
+    if (!ptr.get() || operation.exceedsMemoryBudget()) {
         return Kolab::Event();
     }
+    operation.setObject(*ptr);
     validate(*ptr);
     return *ptr;
 }
 
 std::string writeEvent(const Kolab::Event &event, const std::string& productId)
+{
+    return writeEvent(event, productId, 0);
+}
+
+std::string writeEvent(const Kolab::Event &event, const std::string& productId, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::WriteOperation, EventObject);
     validate(event);
     const std::string result = XCAL::serializeIncidence< XCAL::IncidenceTrait<Kolab::Event> >(event, productId);
-    //Validate
-    XCAL::deserializeIncidence< XCAL::IncidenceTrait<Kolab::Event> >(result, false);
+    operation.setCreatedUid();
+    {
+        //Validate
+        Utils::PhaseTimer timer(SelfCheckPhase);
+        Utils::TraceScope trace("selfCheck", EventObject, result.size(), operation.traceUid());
+        XCAL::deserializeIncidence< XCAL::IncidenceTrait<Kolab::Event> >(result, false);
+    }
+    if (operation.exceedsMemoryBudget()) {
+        return std::string();
+    }
     if (errorOccurred()) {
         LOG("Error occurred while writing.")
     }
+    operation.setBytes(result.size());
     return result;
 }
 
 Kolab::Todo readTodo(const std::string& s, bool isUrl)
+{
+    return readTodo(s, isUrl, 0);
+}
+
+Kolab::Todo readTodo(const std::string& s, bool isUrl, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::ReadOperation, TodoObject, isUrl ? 0 : s.size());
     XCAL::IncidenceTrait<Kolab::Todo>::IncidencePtr ptr = XCAL::deserializeIncidence< XCAL::IncidenceTrait<Kolab::Todo> >(s, isUrl);
-    if (!ptr.get()) {
+    if (!ptr.get() || operation.exceedsMemoryBudget()) {
         return Kolab::Todo();
     }
+    operation.setObject(*ptr);
     validate(*ptr);
     return *ptr;
 }
 
 std::string writeTodo(const Kolab::Todo &event, const std::string& productId)
+{
+    return writeTodo(event, productId, 0);
+}
+
+std::string writeTodo(const Kolab::Todo &event, const std::string& productId, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::WriteOperation, TodoObject);
     validate(event);
     const std::string result = XCAL::serializeIncidence< XCAL::IncidenceTrait<Kolab::Todo> >(event, productId);
-    //Validate
-    XCAL::deserializeIncidence< XCAL::IncidenceTrait<Kolab::Todo> >(result, false);
+    operation.setCreatedUid();
+    {
+        //Validate
+        Utils::PhaseTimer timer(SelfCheckPhase);
+        Utils::TraceScope trace("selfCheck", TodoObject, result.size(), operation.traceUid());
+        XCAL::deserializeIncidence< XCAL::IncidenceTrait<Kolab::Todo> >(result, false);
+    }
+    if (operation.exceedsMemoryBudget()) {
+        return std::string();
+    }
     if (errorOccurred()) {
         LOG("Error occurred while writing.")
     }
+    operation.setBytes(result.size());
     return result;
 }
 
 Journal readJournal(const std::string& s, bool isUrl)
+{
+    return readJournal(s, isUrl, 0);
+}
+
+Journal readJournal(const std::string& s, bool isUrl, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::ReadOperation, JournalObject, isUrl ? 0 : s.size());
     XCAL::IncidenceTrait<Kolab::Journal>::IncidencePtr ptr = XCAL::deserializeIncidence<XCAL::IncidenceTrait<Kolab::Journal> >(s, isUrl);
-    if (!ptr.get()) {
+    if (!ptr.get() || operation.exceedsMemoryBudget()) {
         return Kolab::Journal();
     }
+    operation.setObject(*ptr);
     validate(*ptr);
     return *ptr;
 }
 
 std::string writeJournal(const Kolab::Journal &j, const std::string& productId)
+{
+    return writeJournal(j, productId, 0);
+}
+
+std::string writeJournal(const Kolab::Journal &j, const std::string& productId, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::WriteOperation, JournalObject);
     validate(j);
     const std::string result = XCAL::serializeIncidence< XCAL::IncidenceTrait<Kolab::Journal> >(j, productId);
-    //Validate
-    XCAL::deserializeIncidence< XCAL::IncidenceTrait<Kolab::Journal> >(result, false);
+    operation.setCreatedUid();
+    {
+        //Validate
+        Utils::PhaseTimer timer(SelfCheckPhase);
+        Utils::TraceScope trace("selfCheck", JournalObject, result.size(), operation.traceUid());
+        XCAL::deserializeIncidence< XCAL::IncidenceTrait<Kolab::Journal> >(result, false);
+    }
+    if (operation.exceedsMemoryBudget()) {
+        return std::string();
+    }
     if (errorOccurred()) {
         LOG("Error occurred while writing.")
     }
+    operation.setBytes(result.size());
     return result;
 }
 
 Kolab::Freebusy readFreebusy(const std::string& s, bool isUrl)
+{
+    return readFreebusy(s, isUrl, 0);
+}
+
+Kolab::Freebusy readFreebusy(const std::string& s, bool isUrl, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::ReadOperation, FreebusyObject, isUrl ? 0 : s.size());
     XCAL::IncidenceTrait<Kolab::Freebusy>::IncidencePtr ptr = XCAL::deserializeIncidence<XCAL::IncidenceTrait<Kolab::Freebusy> >(s, isUrl);
-    if (!ptr.get()) {
+    if (!ptr.get() || operation.exceedsMemoryBudget()) {
         return Kolab::Freebusy();
     }
+    operation.setObject(*ptr);
     validate(*ptr);
     return *ptr;
 }
 
 std::string writeFreebusy(const Freebusy &f, const std::string& productId)
+{
+    return writeFreebusy(f, productId, 0);
+}
+
+std::string writeFreebusy(const Freebusy &f, const std::string& productId, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::WriteOperation, FreebusyObject);
     validate(f);
     const std::string result = XCAL::serializeFreebusy<XCAL::IncidenceTrait<Kolab::Freebusy> >(f, productId);
-    XCAL::deserializeIncidence<XCAL::IncidenceTrait<Kolab::Freebusy> >(result, false);
+    operation.setCreatedUid();
+    {
+        //Validate
+        Utils::PhaseTimer timer(SelfCheckPhase);
+        Utils::TraceScope trace("selfCheck", FreebusyObject, result.size(), operation.traceUid());
+        XCAL::deserializeIncidence<XCAL::IncidenceTrait<Kolab::Freebusy> >(result, false);
+    }
+    if (operation.exceedsMemoryBudget()) {
+        return std::string();
+    }
     if (errorOccurred()) {
         LOG("Error occurred while writing.")
     }
+    operation.setBytes(result.size());
     return result;
 }
 
 Kolab::Contact readContact(const std::string& s, bool isUrl)
+{
+    return readContact(s, isUrl, 0);
+}
+
+Kolab::Contact readContact(const std::string& s, bool isUrl, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::ReadOperation, ContactObject, isUrl ? 0 : s.size());
     boost::shared_ptr <Kolab::Contact > ptr = XCARD::deserializeCard<Kolab::Contact>(s, isUrl);
-    if (!ptr.get()) {
+    if (!ptr.get() || operation.exceedsMemoryBudget()) {
         return Kolab::Contact();
     }
+    operation.setObject(*ptr);
     validate(*ptr);
     return *ptr;
 }
 
 std::string writeContact(const Contact &contact, const std::string& productId)
+{
+    return writeContact(contact, productId, 0);
+}
+
+std::string writeContact(const Contact &contact, const std::string& productId, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::WriteOperation, ContactObject);
     validate(contact);
     const std::string result = XCARD::serializeCard(contact, productId);
-    //Validate
-    XCARD::deserializeCard<Kolab::Contact>(result, false);
+    operation.setCreatedUid();
+    {
+        //Validate
+        Utils::PhaseTimer timer(SelfCheckPhase);
+        Utils::TraceScope trace("selfCheck", ContactObject, result.size(), operation.traceUid());
+        XCARD::deserializeCard<Kolab::Contact>(result, false);
+    }
+    if (operation.exceedsMemoryBudget()) {
+        return std::string();
+    }
     if (errorOccurred()) {
         LOG("Error occurred while writing.")
     }
+    operation.setBytes(result.size());
     return result;
 }
 
 DistList readDistlist(const std::string& s, bool isUrl)
+{
+    return readDistlist(s, isUrl, 0);
+}
+
+DistList readDistlist(const std::string& s, bool isUrl, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::ReadOperation, DistlistObject, isUrl ? 0 : s.size());
     boost::shared_ptr <Kolab::DistList> ptr = XCARD::deserializeCard<Kolab::DistList>(s, isUrl);
-    if (!ptr.get()) {
+    if (!ptr.get() || operation.exceedsMemoryBudget()) {
         return Kolab::DistList();
     }
+    operation.setObject(*ptr);
     validate(*ptr);
     return *ptr;
 }
 
 std::string writeDistlist(const DistList &list, const std::string& productId)
+{
+    return writeDistlist(list, productId, 0);
+}
+
+std::string writeDistlist(const DistList &list, const std::string& productId, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::WriteOperation, DistlistObject);
     validate(list);
     const std::string result = XCARD::serializeCard(list, productId);
-    //Validate
-    XCARD::deserializeCard<Kolab::DistList>(result, false);
+    operation.setCreatedUid();
+    {
+        //Validate
+        Utils::PhaseTimer timer(SelfCheckPhase);
+        Utils::TraceScope trace("selfCheck", DistlistObject, result.size(), operation.traceUid());
+        XCARD::deserializeCard<Kolab::DistList>(result, false);
+    }
+    if (operation.exceedsMemoryBudget()) {
+        return std::string();
+    }
     if (errorOccurred()) {
         LOG("Error occurred while writing.")
     }
+    operation.setBytes(result.size());
     return result;
 }
 
 Note readNote(const std::string& s, bool isUrl)
+{
+    return readNote(s, isUrl, 0);
+}
+
+Note readNote(const std::string& s, bool isUrl, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::ReadOperation, NoteObject, isUrl ? 0 : s.size());
     boost::shared_ptr <Kolab::Note> ptr = Kolab::KolabObjects::deserializeObject<Kolab::Note>(s, isUrl);
-    if (!ptr.get()) {
+    if (!ptr.get() || operation.exceedsMemoryBudget()) {
         return Kolab::Note();
     }
+    operation.setObject(*ptr);
     validate(*ptr);
     return *ptr;
 }
 
 std::string writeNote(const Note &note, const std::string& productId)
+{
+    return writeNote(note, productId, 0);
+}
+
+std::string writeNote(const Note &note, const std::string& productId, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::WriteOperation, NoteObject);
     validate(note);
     const std::string result = Kolab::KolabObjects::serializeObject<Kolab::Note>(note, productId);
-    //Validate
-    Kolab::KolabObjects::deserializeObject<Kolab::Note>(result, false);
+    operation.setCreatedUid();
+    {
+        //Validate
+        Utils::PhaseTimer timer(SelfCheckPhase);
+        Utils::TraceScope trace("selfCheck", NoteObject, result.size(), operation.traceUid());
+        Kolab::KolabObjects::deserializeObject<Kolab::Note>(result, false);
+    }
+    if (operation.exceedsMemoryBudget()) {
+        return std::string();
+    }
     if (errorOccurred()) {
         LOG("Error occurred while writing.")
     }
+    operation.setBytes(result.size());
     return result;
 }
 
 File readFile(const std::string& s, bool isUrl)
+{
+    return readFile(s, isUrl, 0);
+}
+
+File readFile(const std::string& s, bool isUrl, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::ReadOperation, FileObject, isUrl ? 0 : s.size());
     boost::shared_ptr <Kolab::File> ptr = Kolab::KolabObjects::deserializeObject<Kolab::File>(s, isUrl);
-    if (!ptr.get()) {
+    if (!ptr.get() || operation.exceedsMemoryBudget()) {
         return Kolab::File();
     }
+    operation.setObject(*ptr);
     validate(*ptr);
     return *ptr;
 }
 
 std::string writeFile(const File &file, const std::string& productId)
+{
+    return writeFile(file, productId, 0);
+}
+
+std::string writeFile(const File &file, const std::string& productId, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::WriteOperation, FileObject);
     validate(file);
     const std::string result = Kolab::KolabObjects::serializeObject<Kolab::File>(file, productId);
-    //Validate
-    Kolab::KolabObjects::deserializeObject<Kolab::File>(result, false);
+    operation.setCreatedUid();
+    {
+        //Validate
+        Utils::PhaseTimer timer(SelfCheckPhase);
+        Utils::TraceScope trace("selfCheck", FileObject, result.size(), operation.traceUid());
+        Kolab::KolabObjects::deserializeObject<Kolab::File>(result, false);
+    }
+    if (operation.exceedsMemoryBudget()) {
+        return std::string();
+    }
     if (errorOccurred()) {
         LOG("Error occurred while writing.")
     }
+    operation.setBytes(result.size());
     return result;
 }
 
 Configuration readConfiguration(const std::string& s, bool isUrl)
+{
+    return readConfiguration(s, isUrl, 0);
+}
+
+Configuration readConfiguration(const std::string& s, bool isUrl, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::ReadOperation, ConfigurationObject, isUrl ? 0 : s.size());
     boost::shared_ptr <Kolab::Configuration> ptr = Kolab::KolabObjects::deserializeObject<Kolab::Configuration>(s, isUrl);
-    if (!ptr.get()) {
+    if (!ptr.get() || operation.exceedsMemoryBudget()) {
         return Kolab::Configuration();
     }
+    operation.setObject(*ptr);
     validate(*ptr);
     return *ptr;
 }
 
 std::string writeConfiguration(const Configuration &config, const std::string& productId)
+{
+    return writeConfiguration(config, productId, 0);
+}
+
+std::string writeConfiguration(const Configuration &config, const std::string& productId, std::vector<Diagnostic> *diagnostics)
 {
     Utils::clearErrors();
+    Utils::DiagnosticsOutput output(diagnostics);
+    Utils::OperationScope operation(Utils::WriteOperation, ConfigurationObject);
     validate(config);
     const std::string result = Kolab::KolabObjects::serializeObject<Kolab::Configuration>(config, productId);
-    //Validate
-    Kolab::KolabObjects::deserializeObject<Kolab::Configuration>(result, false);
+    operation.setCreatedUid();
+    {
+        //Validate
+        Utils::PhaseTimer timer(SelfCheckPhase);
+        Utils::TraceScope trace("selfCheck", ConfigurationObject, result.size(), operation.traceUid());
+        Kolab::KolabObjects::deserializeObject<Kolab::Configuration>(result, false);
+    }
+    if (operation.exceedsMemoryBudget()) {
+        return std::string();
+    }
     if (errorOccurred()) {
         LOG("Error occurred while writing.")
     }
+    operation.setBytes(result.size());
     return result;
 }
 
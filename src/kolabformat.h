@@ -19,6 +19,7 @@
 #define KOLABFORMAT_H
 
 #include <string>
+#include <vector>
 #include "kolabcontainers.h"
 #include "kolabtodo.h"
 #include "kolabevent.h"
@@ -29,6 +30,7 @@
 #include "kolabfreebusy.h"
 #include "kolabfile.h"
 #include "global_definitions.h"
+#include "kolabmetrics.h"
 
 /**
  * Kolab Format v3 Implementation
@@ -55,6 +57,45 @@
  */
 namespace Kolab {
 
+/**
+ * Pays the startup costs of the library in advance, i.e. before a server starts handling requests.
+ *
+ * Initializes Xerces and loads the schema grammar for the whole process (otherwise done on first use),
+ * and creates a parser for the calling thread plus one for each of the given number of threads
+ * (i.e. the size of a thread pool), which threads pick up on their first read. All parsers parse a small document once.
+ *
+ * Without initialize(), Xerces is initialized and the grammar loaded on first use, and both are kept for the lifetime of the
+ * process (so threads coming and going don't pay for them again).
+ *
+ * shutdown() releases these resources again, except the parsers threads have picked up (which live as long as their thread,
+ * and keep Xerces initialized until then). Calls can be nested, the last shutdown() matching an initialize() releases the resources.
+ * The library is usable without calling either function.
+ *
+ * Pre-forking servers should call initialize() in the master process: the children inherit the grammar and the parsers
+ * copy-on-write, instead of loading them in every child (see src/DEVELOPMENT for the state which is safe to inherit across fork()).
+ * Returns false if the grammar could not be loaded.
+ */
+bool initialize(unsigned int threads = 0);
+void shutdown();
+
+/**
+ * By default every thread which reads keeps a parser (with its buffers) for its lifetime. For elastic thread pools,
+ * where memory should follow the number of concurrent reads rather than the number of threads ever started,
+ * a bounded pool can be used instead: every read checks a parser out of the pool and returns it once the document is parsed.
+ *
+ * At most maxParsers reads parse at once, further reads wait for a parser to be returned. Parsers idle for longer than
+ * idleTimeout milliseconds are released when parsers are checked out or returned, and by releaseThreadResources()
+ * (0 keeps them). Passing 0 maxParsers restores the parsers per thread. Should be set before reading concurrently.
+ */
+void setParserPool(unsigned int maxParsers, unsigned long idleTimeout = 0);
+
+/**
+ * Releases the parser of the calling thread (i.e. when a worker thread goes idle) and the expired idle parsers of the pool.
+ *
+ * The next read of the thread creates (or checks out) a parser again.
+ */
+void releaseThreadResources();
+
 /**
  * Check to see if serialization/deserialization was successful.
  *
@@ -74,6 +115,86 @@ Kolab::ErrorSeverity error();
  */
 std::string errorMessage();
 
+/**
+ * Returns all warnings and errors of the last serialization/deserialization of the calling thread, in the order they occurred.
+ *
+ * Schema violations are reported with their line and column in the document.
+ * The list is empty if the operation was successful.
+ * To receive the diagnostics of a single call along with its result (i.e. when the calls of a thread are interleaved
+ * by a scheduler), pass a list to the diagnostics parameter of the read and write functions instead.
+ */
+std::vector<Kolab::Diagnostic> diagnostics();
+
+/**
+ * Use this function to receive the log output of the library (instead of printing it to stdout/stderr).
+ *
+ * The handler is called for all messages with a severity of at least the log threshold, 0 disables the output.
+ * Pass defaultLogHandler to print the messages again.
+ * The error state (error(), errorMessage()) is maintained independently of the log output.
+ *
+ * Both settings apply to the whole process, so they should be set before the library is used from several threads.
+ */
+typedef void (*LogHandler)(Kolab::ErrorSeverity severity, const std::string &message);
+void setLogHandler(LogHandler handler);
+void defaultLogHandler(Kolab::ErrorSeverity severity, const std::string &message);
+
+/**
+ * Messages below this severity are not passed to the log handler (and not even built).
+ *
+ * Defaults to NoError, i.e. everything including debug messages is logged.
+ */
+void setLogThreshold(Kolab::ErrorSeverity threshold);
+
+/**
+ * Enables the timing of the individual phases of every read and write (disabled by default).
+ *
+ * phaseStatistics() returns the aggregated durations per object type and phase, for all threads.
+ * The phases of the check a write does by reading back the written document are accounted to the SelfCheckPhase only.
+ */
+void setInstrumentationEnabled(bool enabled);
+std::vector<Kolab::PhaseStatistics> phaseStatistics();
+void resetPhaseStatistics();
+
+/**
+ * Memory accounting of the allocations done through Xerces (the DOM and the parser buffers).
+ *
+ * Disabled by default, so the allocations are not slowed down. The statistics are only updated while the accounting is enabled,
+ * either with setMemoryAccountingEnabled() or by setting a memory budget.
+ * The objects of the xsd object model and the containers are allocated using the global operator new and are not included.
+ * lastOperationMemory() returns the statistics of the last read or write of the calling thread,
+ * threadPeakMemory() the maximum amount of memory the calling thread held through Xerces (including the parser itself, if it was created while the accounting was enabled).
+ *
+ * With a memory budget set (i.e. in tests), reads and writes which held more than the budget at once fail with a critical
+ * ResourceLimitError, and return an empty result like for the other resource limits.
+ * 0 disables the check (the default).
+ */
+void setMemoryAccountingEnabled(bool enabled);
+Kolab::MemoryStatistics lastOperationMemory();
+unsigned long threadPeakMemory();
+void setMemoryBudget(unsigned long bytes);
+
+/**
+ * Installs hooks which are called at the begin and end of every read and write, of the check a write does by reading back
+ * the written document ("selfCheck") and of the loading of the schema grammar ("loadGrammar", once per process).
+ *
+ * Meant to create spans for distributed tracing. The hooks are called on the thread doing the work, the UID and the size
+ * of a written document and the duration are only known at the end. Pass 0 to remove a hook, without hooks the cost is a single branch.
+ * The grammar is loaded while a lock is held, so its hooks are called right after each other once it is loaded
+ * (and may call back into the library), its duration is only given by the end.
+ */
+typedef void (*TraceHook)(const Kolab::TraceInfo &info);
+void setTracer(TraceHook begin, TraceHook end);
+
+/**
+ * Limits which protect against malicious or broken objects (i.e. a huge inline photo or millions of freebusy periods).
+ *
+ * The limits apply to every read (and the self-check of every write) in the process and should be set before objects are read concurrently.
+ * An object exceeding a limit is rejected early with a critical ResourceLimitError, and the read returns an empty object
+ * (nothing of the object is returned, whichever limit is hit).
+ */
+void setResourceLimits(const Kolab::ResourceLimits &limits);
+Kolab::ResourceLimits resourceLimits();
+
 /**
  * Returns productId string of the last deserialized object.
  * Updated during deserialization of object.
@@ -103,6 +224,13 @@ std::string getSerializedUID();
  */
 std::string generateUID();
 
+/**
+ * Returns count generated uids.
+ *
+ * Cheaper than calling generateUID() count times, i.e. for bulk imports.
+ */
+std::vector<std::string> generateUIDs(int count);
+
 /**
  * Use this function to override the timestamp which is normally generated upon serialization from the system time.
  * To override the timestamp call this function once. You will need to clear the timestamp manually by setting a default constructed cDateTime().
@@ -115,6 +243,16 @@ std::string generateUID();
  */
 void overrideTimestamp(const Kolab::cDateTime &dt);
 
+/**
+ * Use this function to supply the clock which is used instead of the system time upon serialization.
+ *
+ * The provider is called once per write (if a timestamp is needed at all) and must return a UTC timestamp.
+ * Like overrideTimestamp it applies to the calling thread only, and an overridden timestamp takes precedence.
+ * Set it to 0 to use the system time again.
+ */
+typedef Kolab::cDateTime (*TimestampProvider)();
+void setTimestampProvider(TimestampProvider provider);
+
 /**
  * Serializing functions for kolab objects.
  * 
@@ -122,34 +260,54 @@ void overrideTimestamp(const Kolab::cDateTime &dt);
  * 
  * @param isUrl if true, the file with the url @param s is opened and read.
  * @param productId Sets the productid on serialization. Note that the versionstring of libkolabxml will be appended to the productId.
+ * @param diagnostics If not 0, receives the warnings and errors of this call (the same as diagnostics() right after it).
+ * The overloads without it are kept for binary compatibility.
  */
 
 Kolab::Event readEvent(const std::string& s, bool isUrl);
+Kolab::Event readEvent(const std::string& s, bool isUrl, std::vector<Kolab::Diagnostic> *diagnostics);
 std::string writeEvent(const Kolab::Event &, const std::string& productId = std::string());
+std::string writeEvent(const Kolab::Event &, const std::string& productId, std::vector<Kolab::Diagnostic> *diagnostics);
 
 Kolab::Todo readTodo(const std::string& s, bool isUrl);
+Kolab::Todo readTodo(const std::string& s, bool isUrl, std::vector<Kolab::Diagnostic> *diagnostics);
 std::string writeTodo(const Kolab::Todo &, const std::string& productId = std::string());
+std::string writeTodo(const Kolab::Todo &, const std::string& productId, std::vector<Kolab::Diagnostic> *diagnostics);
 
 Kolab::Journal readJournal(const std::string& s, bool isUrl);
+Kolab::Journal readJournal(const std::string& s, bool isUrl, std::vector<Kolab::Diagnostic> *diagnostics);
 std::string writeJournal(const Kolab::Journal &, const std::string& productId = std::string());
+std::string writeJournal(const Kolab::Journal &, const std::string& productId, std::vector<Kolab::Diagnostic> *diagnostics);
 
 Kolab::Freebusy readFreebusy(const std::string& s, bool isUrl);
+Kolab::Freebusy readFreebusy(const std::string& s, bool isUrl, std::vector<Kolab::Diagnostic> *diagnostics);
 std::string writeFreebusy(const Kolab::Freebusy &, const std::string& productId = std::string());
+std::string writeFreebusy(const Kolab::Freebusy &, const std::string& productId, std::vector<Kolab::Diagnostic> *diagnostics);
 
 Kolab::Contact readContact(const std::string& s, bool isUrl);
+Kolab::Contact readContact(const std::string& s, bool isUrl, std::vector<Kolab::Diagnostic> *diagnostics);
 std::string writeContact(const Kolab::Contact &, const std::string& productId = std::string());
+std::string writeContact(const Kolab::Contact &, const std::string& productId, std::vector<Kolab::Diagnostic> *diagnostics);
 
 Kolab::DistList readDistlist(const std::string& s, bool isUrl);
+Kolab::DistList readDistlist(const std::string& s, bool isUrl, std::vector<Kolab::Diagnostic> *diagnostics);
 std::string writeDistlist(const Kolab::DistList &, const std::string& productId = std::string());
+std::string writeDistlist(const Kolab::DistList &, const std::string& productId, std::vector<Kolab::Diagnostic> *diagnostics);
 
 Kolab::Note readNote(const std::string& s, bool isUrl);
+Kolab::Note readNote(const std::string& s, bool isUrl, std::vector<Kolab::Diagnostic> *diagnostics);
 std::string writeNote(const Kolab::Note &, const std::string& productId = std::string());
+std::string writeNote(const Kolab::Note &, const std::string& productId, std::vector<Kolab::Diagnostic> *diagnostics);
 
 Kolab::Configuration readConfiguration(const std::string& s, bool isUrl);
+Kolab::Configuration readConfiguration(const std::string& s, bool isUrl, std::vector<Kolab::Diagnostic> *diagnostics);
 std::string writeConfiguration(const Kolab::Configuration &, const std::string& productId = std::string());
+std::string writeConfiguration(const Kolab::Configuration &, const std::string& productId, std::vector<Kolab::Diagnostic> *diagnostics);
 
 Kolab::File readFile(const std::string& s, bool isUrl);
+Kolab::File readFile(const std::string& s, bool isUrl, std::vector<Kolab::Diagnostic> *diagnostics);
 std::string writeFile(const Kolab::File &, const std::string& productId = std::string());
+std::string writeFile(const Kolab::File &, const std::string& productId, std::vector<Kolab::Diagnostic> *diagnostics);
 
 }
 
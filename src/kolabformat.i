@@ -6,6 +6,7 @@
     #define SWIG_PYTHON_EXTRA_NATIVE_CONTAINERS 
 
     #include "global_definitions.h"
+    #include "kolabmetrics.h"
     #include "kolabformat.h"
     #include "containers/kolabcontainers.h"
     #include "containers/kolabevent.h"
@@ -49,12 +50,22 @@ namespace std {
     %template(vectorsnippet) vector<Kolab::Snippet>;
     %template(vectorfreebusyperiod) vector<Kolab::FreebusyPeriod>;
     %template(vectorperiod) vector<Kolab::Period>;
+    %template(vectordiagnostic) vector<Kolab::Diagnostic>;
+    %template(vectorphasestatistics) vector<Kolab::PhaseStatistics>;
 };
 
 %rename(readKolabFile) Kolab::readFile;
 %rename(writeKolabFile) Kolab::writeFile;
 
+/* Native function pointers can't be supplied from the bindings */
+%ignore Kolab::setTimestampProvider;
+%ignore Kolab::setLogHandler;
+%ignore Kolab::defaultLogHandler;
+%ignore Kolab::setTracer;
+%ignore Kolab::TraceInfo;
+
 %include "global_definitions.h"
+%include "kolabmetrics.h"
 %include "kolabformat.h"
 %include "containers/kolabcontainers.h"
 %include "containers/kolabevent.h"
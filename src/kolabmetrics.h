@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2012  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KOLABMETRICS_H
+#define KOLABMETRICS_H
+
+#include <string>
+#include <boost/scoped_ptr.hpp>
+#include "global_definitions.h"
+
+namespace Kolab {
+
+/**
+ * Operation counters and latency histograms of the reads and writes of all threads.
+ *
+ * Obtained using Kolab::metricsSnapshot(), the values are counted since the last Kolab::resetMetrics().
+ * A read or write is counted as failed with the highest severity of its errors (see Kolab::error()).
+ */
+class MetricsSnapshot {
+public:
+    MetricsSnapshot();
+    ~MetricsSnapshot();
+    MetricsSnapshot(const MetricsSnapshot &);
+    void operator=(const MetricsSnapshot &);
+
+    unsigned long reads(ObjectType) const;
+    unsigned long writes(ObjectType) const;
+
+    /**
+     * Size of the read (excluding reads from files) and written documents.
+     */
+    unsigned long bytesRead(ObjectType) const;
+    unsigned long bytesWritten(ObjectType) const;
+
+    unsigned long failedReads(ObjectType, ErrorSeverity) const;
+    unsigned long failedWrites(ObjectType, ErrorSeverity) const;
+
+    /**
+     * The latency in microseconds below which the given fraction (0.0 - 1.0) of the reads/writes completed.
+     *
+     * The latencies are collected in power of two buckets, so this is an upper bound which is off by at most a factor of two.
+     * Returns 0 if there were no reads/writes.
+     */
+    double readLatency(ObjectType, double fraction) const;
+    double writeLatency(ObjectType, double fraction) const;
+
+    /**
+     * All values in a line based text format (the Prometheus text exposition format), i.e.:
+     * kolab_reads_total{type="event"} 42
+     */
+    std::string toText() const;
+
+private:
+    friend MetricsSnapshot metricsSnapshot();
+    struct Private;
+    boost::scoped_ptr<Private> d;
+};
+
+/**
+ * Returns the current values.
+ */
+MetricsSnapshot metricsSnapshot();
+
+/**
+ * Restarts counting from zero.
+ */
+void resetMetrics();
+
+}
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2012  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memoryaccounting.h"
+#include "utils.h"
+#include "numericstrings.h"
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <climits>
+
+namespace Kolab {
+    namespace Utils {
+
+static unsigned long budget = 0;
+static bool enabled = false;
+//enabled or a budget set
+static bool accounting = false;
+
+struct MemoryState {
+    MemoryState(): allocations(0), allocatedBytes(0), current(0), peak(0), operationPeak(0) {};
+    unsigned long allocations;
+    unsigned long allocatedBytes;
+    //Memory may be freed by another thread than the one which allocated it, so this can drop below 0
+    long current;
+    unsigned long peak;
+    unsigned long operationPeak;
+    MemoryStatistics lastOperation;
+};
+
+static boost::thread_specific_ptr<MemoryState> statePtr;
+
+static MemoryState &state()
+{
+    MemoryState *s = statePtr.get();
+    if (!s) {
+        s = new MemoryState();
+        statePtr.reset(s);
+    }
+    return *s;
+}
+
+static unsigned long current(const MemoryState &s)
+{
+    return s.current > 0 ? static_cast<unsigned long>(s.current) : 0;
+}
+
+void accountAllocation(std::size_t size)
+{
+    if (!accounting) {
+        return;
+    }
+    MemoryState &s = state();
+    s.allocations++;
+    s.allocatedBytes += size;
+    s.current += static_cast<long>(size);
+    if (current(s) > s.operationPeak) {
+        s.operationPeak = current(s);
+    }
+    if (current(s) > s.peak) {
+        s.peak = current(s);
+    }
+}
+
+void accountDeallocation(std::size_t size)
+{
+    if (!accounting) {
+        return;
+    }
+    //Don't recreate the state if the parser is destroyed after it on thread exit
+    MemoryState *s = statePtr.get();
+    if (s) {
+        s->current -= static_cast<long>(size);
+    }
+}
+
+MemoryStatistics getLastOperationMemory()
+{
+    return state().lastOperation;
+}
+
+unsigned long getThreadPeakMemory()
+{
+    return state().peak;
+}
+
+void setMemoryAccountingEnabled(bool e)
+{
+    enabled = e;
+    accounting = enabled || budget;
+}
+
+void setMemoryBudget(unsigned long bytes)
+{
+    budget = bytes;
+    accounting = enabled || budget;
+}
+
+MemoryScope::MemoryScope()
+:   mActive(accounting)
+{
+    if (!mActive) {
+        return;
+    }
+    MemoryState &s = state();
+    mAllocations = s.allocations;
+    mAllocatedBytes = s.allocatedBytes;
+    mCurrent = current(s);
+    mPreviousPeak = s.operationPeak;
+    s.operationPeak = mCurrent;
+}
+
+MemoryScope::~MemoryScope()
+{
+    stop();
+}
+
+bool MemoryScope::stop()
+{
+    if (!mActive) {
+        return false;
+    }
+    mActive = false;
+    MemoryState &s = state();
+    MemoryStatistics &stats = s.lastOperation;
+    stats.allocations = s.allocations - mAllocations;
+    stats.allocatedBytes = s.allocatedBytes - mAllocatedBytes;
+    stats.peakBytes = s.operationPeak > mCurrent ? s.operationPeak - mCurrent : 0;
+    if (mPreviousPeak > s.operationPeak) {
+        s.operationPeak = mPreviousPeak;
+    }
+    if (budget && stats.peakBytes > budget) {
+        std::string message("memory budget exceeded: ");
+        appendInt(message, static_cast<int>(std::min(stats.peakBytes, static_cast<unsigned long>(INT_MAX))));
+        message.append(" bytes");
+        logMessage(message, __FILE__, __LINE__, Critical, ResourceLimitError);
+        return true;
+    }
+    return false;
+}
+
+    }
+}
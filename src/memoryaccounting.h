@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2012  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEMORYACCOUNTING_H
+#define MEMORYACCOUNTING_H
+
+#include <cstddef>
+#include "global_definitions.h"
+
+namespace Kolab {
+    namespace Utils {
+
+/**
+ * Accounting of the memory allocated through Xerces, per thread.
+ *
+ * Called by the memory manager handed to Xerces for every (de)allocation. While the accounting is disabled
+ * (neither enabled nor a budget set), this costs a check of a global flag.
+ */
+void accountAllocation(std::size_t size);
+void accountDeallocation(std::size_t size);
+
+/**
+ * The statistics of the last read or write of the calling thread.
+ */
+MemoryStatistics getLastOperationMemory();
+
+/**
+ * The maximum amount of memory held through Xerces by the calling thread.
+ */
+unsigned long getThreadPeakMemory();
+
+/**
+ * Enables the accounting (disabled by default), the statistics are only updated while it is enabled.
+ */
+void setMemoryAccountingEnabled(bool enabled);
+
+/**
+ * Operations holding more than bytes at once fail with a critical ResourceLimitError, 0 disables the check.
+ * A budget enables the accounting as well.
+ */
+void setMemoryBudget(unsigned long bytes);
+
+/**
+ * Accounts the allocations of an operation until it is stopped or goes out of scope.
+ *
+ * stop() returns true if the operation exceeded the memory budget (which has been logged), only the first call checks.
+ */
+class MemoryScope
+{
+public:
+    MemoryScope();
+    ~MemoryScope();
+    bool stop();
+private:
+    MemoryScope(const MemoryScope &);
+    MemoryScope &operator=(const MemoryScope &);
+    bool mActive;
+    unsigned long mAllocations;
+    unsigned long mAllocatedBytes;
+    unsigned long mCurrent;
+    unsigned long mPreviousPeak;
+};
+
+    }
+}
+
+#endif
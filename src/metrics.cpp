@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2012  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics.h"
+#include "kolabmetrics.h"
+#include "utils.h"
+#include "numericstrings.h"
+#include "resourcelimits.h"
+#include <boost/thread.hpp>
+#include <vector>
+#include <algorithm>
+
+namespace Kolab {
+    namespace Utils {
+
+static const int objectTypeCount = ConfigurationObject + 1;
+static const int operationCount = WriteOperation + 1;
+static const int severityCount = Critical + 1;
+//Bucket 0 holds latencies below 1us, bucket i latencies below 2^i us
+static const int latencyBucketCount = 32;
+
+struct Counters {
+    unsigned long operations[objectTypeCount][operationCount];
+    unsigned long bytes[objectTypeCount][operationCount];
+    unsigned long failures[objectTypeCount][operationCount][severityCount];
+    unsigned long latency[objectTypeCount][operationCount][latencyBucketCount];
+};
+
+/**
+ * The counters of one thread.
+ *
+ * Only the owning thread writes to its shard, the atomic increments are uncontended and only make the values readable from snapshots.
+ */
+struct Shard {
+    Shard() { std::fill(reinterpret_cast<unsigned long*>(&counters), reinterpret_cast<unsigned long*>(&counters + 1), 0ul); };
+    Counters counters;
+};
+
+static boost::mutex registryMutex;
+static const bool registryMutexProtected = protectAcrossFork(registryMutex);
+//The shards of the running threads
+static std::vector<Shard*> shards;
+//The sum of the shards of the exited threads
+static Shard retired;
+//The values at the last reset
+static Shard baseline;
+
+static void retireShard(Shard *shard)
+{
+    boost::mutex::scoped_lock lock(registryMutex);
+    unsigned long *from = reinterpret_cast<unsigned long*>(&shard->counters);
+    unsigned long *to = reinterpret_cast<unsigned long*>(&retired.counters);
+    const std::size_t count = sizeof(Counters) / sizeof(unsigned long);
+    for (std::size_t i = 0; i < count; i++) {
+        to[i] += from[i];
+    }
+    shards.erase(std::remove(shards.begin(), shards.end(), shard), shards.end());
+    delete shard;
+}
+
+static boost::thread_specific_ptr<Shard> shardPtr(&retireShard);
+
+static Shard &shard()
+{
+    Shard *s = shardPtr.get();
+    if (!s) {
+        s = new Shard();
+        boost::mutex::scoped_lock lock(registryMutex);
+        shards.push_back(s);
+        shardPtr.reset(s);
+    }
+    return *s;
+}
+
+static inline void increment(unsigned long &value, unsigned long amount = 1)
+{
+    atomicAdd(value, amount);
+}
+
+static int latencyBucket(unsigned long long nanoseconds)
+{
+    unsigned long long microseconds = nanoseconds / 1000;
+    int bucket = 0;
+    while (microseconds && bucket < latencyBucketCount - 1) {
+        microseconds >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * Sums up all shards (minus the baseline), must be called with the registry locked.
+ */
+static void sumShards(Counters &result)
+{
+    unsigned long *to = reinterpret_cast<unsigned long*>(&result);
+    const unsigned long *from = reinterpret_cast<const unsigned long*>(&retired.counters);
+    const unsigned long *base = reinterpret_cast<const unsigned long*>(&baseline.counters);
+    const std::size_t count = sizeof(Counters) / sizeof(unsigned long);
+    for (std::size_t i = 0; i < count; i++) {
+        to[i] = from[i] - base[i];
+    }
+    for (std::vector<Shard*>::const_iterator it = shards.begin(); it != shards.end(); ++it) {
+        unsigned long *values = reinterpret_cast<unsigned long*>(&(*it)->counters);
+        for (std::size_t i = 0; i < count; i++) {
+            to[i] += atomicAdd(values[i], 0);
+        }
+    }
+}
+
+OperationScope::OperationScope(Operation operation, ObjectType type, std::size_t bytes)
+:   mObjectType(type),
+    mTrace(operation == ReadOperation ? "read" : "write", type, bytes),
+    mOperation(operation),
+    mType(type),
+    mBytes(bytes),
+    mStart(monotonicTime())
+{
+    startResourceClock(mStart);
+}
+
+OperationScope::~OperationScope()
+{
+    //Before the error is looked at, the budget check can fail the operation
+    mMemory.stop();
+    const unsigned long long duration = monotonicTime() - mStart;
+    Counters &c = shard().counters;
+    increment(c.operations[mType][mOperation]);
+    increment(c.bytes[mType][mOperation], mBytes);
+    const ErrorSeverity severity = getError();
+    if (severity != NoError) {
+        increment(c.failures[mType][mOperation][severity]);
+    }
+    increment(c.latency[mType][mOperation][latencyBucket(duration)]);
+}
+
+void OperationScope::setBytes(std::size_t bytes)
+{
+    mBytes = bytes;
+    mTrace.setSize(bytes);
+}
+
+    }
+
+struct MetricsSnapshot::Private {
+    Private() { std::fill(reinterpret_cast<unsigned long*>(&counters), reinterpret_cast<unsigned long*>(&counters + 1), 0ul); };
+    Utils::Counters counters;
+
+    double latency(ObjectType type, Utils::Operation operation, double fraction) const
+    {
+        const unsigned long *buckets = counters.latency[type][operation];
+        const unsigned long total = counters.operations[type][operation];
+        if (!total) {
+            return 0;
+        }
+        const double rank = std::max(fraction, 0.0) * static_cast<double>(total);
+        unsigned long cumulative = 0;
+        for (int bucket = 0; bucket < Utils::latencyBucketCount; bucket++) {
+            cumulative += buckets[bucket];
+            if (static_cast<double>(cumulative) >= rank && cumulative) {
+                return static_cast<double>(1ul << bucket);
+            }
+        }
+        return static_cast<double>(1ul << (Utils::latencyBucketCount - 1));
+    }
+};
+
+MetricsSnapshot::MetricsSnapshot()
+:   d(new MetricsSnapshot::Private())
+{
+}
+
+MetricsSnapshot::~MetricsSnapshot()
+{
+}
+
+MetricsSnapshot::MetricsSnapshot(const MetricsSnapshot &other)
+:   d(new MetricsSnapshot::Private())
+{
+    *d = *other.d;
+}
+
+void MetricsSnapshot::operator=(const MetricsSnapshot &other)
+{
+    *d = *other.d;
+}
+
+unsigned long MetricsSnapshot::reads(ObjectType type) const
+{
+    return d->counters.operations[type][Utils::ReadOperation];
+}
+
+unsigned long MetricsSnapshot::writes(ObjectType type) const
+{
+    return d->counters.operations[type][Utils::WriteOperation];
+}
+
+unsigned long MetricsSnapshot::bytesRead(ObjectType type) const
+{
+    return d->counters.bytes[type][Utils::ReadOperation];
+}
+
+unsigned long MetricsSnapshot::bytesWritten(ObjectType type) const
+{
+    return d->counters.bytes[type][Utils::WriteOperation];
+}
+
+unsigned long MetricsSnapshot::failedReads(ObjectType type, ErrorSeverity severity) const
+{
+    return d->counters.failures[type][Utils::ReadOperation][severity];
+}
+
+unsigned long MetricsSnapshot::failedWrites(ObjectType type, ErrorSeverity severity) const
+{
+    return d->counters.failures[type][Utils::WriteOperation][severity];
+}
+
+double MetricsSnapshot::readLatency(ObjectType type, double fraction) const
+{
+    return d->latency(type, Utils::ReadOperation, fraction);
+}
+
+double MetricsSnapshot::writeLatency(ObjectType type, double fraction) const
+{
+    return d->latency(type, Utils::WriteOperation, fraction);
+}
+
+static const char *const typeNames[] = { "unknown", "event", "todo", "journal", "freebusy", "contact", "distlist", "note", "file", "configuration" };
+static const char *const operationNames[] = { "read", "write" };
+static const char *const severityNames[] = { "none", "warning", "error", "critical" };
+static const char *const quantiles[] = { "0.5", "0.9", "0.99" };
+static const double quantileValues[] = { 0.5, 0.9, 0.99 };
+
+static void appendLine(std::string &out, const char *metric, const char *operation, const char *type, const char *labelName, const char *labelValue, unsigned long value)
+{
+    out.append("kolab_");
+    out.append(operation);
+    out.append(metric);
+    out.append("{type=\"");
+    out.append(type);
+    out.push_back('"');
+    if (labelName) {
+        out.push_back(',');
+        out.append(labelName);
+        out.append("=\"");
+        out.append(labelValue);
+        out.push_back('"');
+    }
+    out.append("} ");
+    char buffer[32];
+    std::size_t length = 0;
+    //appendInt only handles int
+    do {
+        buffer[sizeof(buffer) - 1 - length++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    out.append(buffer + sizeof(buffer) - length, length);
+    out.push_back('\n');
+}
+
+std::string MetricsSnapshot::toText() const
+{
+    std::string out;
+    for (int type = 0; type < Utils::objectTypeCount; type++) {
+        for (int operation = 0; operation < Utils::operationCount; operation++) {
+            const unsigned long count = d->counters.operations[type][operation];
+            if (!count) {
+                continue;
+            }
+            const char *name = operationNames[operation];
+            appendLine(out, "s_total", name, typeNames[type], 0, 0, count);
+            appendLine(out, "_bytes_total", name, typeNames[type], 0, 0, d->counters.bytes[type][operation]);
+            for (int severity = Warning; severity < Utils::severityCount; severity++) {
+                appendLine(out, "_failures_total", name, typeNames[type], "severity", severityNames[severity], d->counters.failures[type][operation][severity]);
+            }
+            for (std::size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+                const double latency = d->latency(static_cast<ObjectType>(type), static_cast<Utils::Operation>(operation), quantileValues[q]);
+                appendLine(out, "_latency_microseconds", name, typeNames[type], "quantile", quantiles[q], static_cast<unsigned long>(latency));
+            }
+        }
+    }
+    return out;
+}
+
+MetricsSnapshot metricsSnapshot()
+{
+    MetricsSnapshot snapshot;
+    boost::mutex::scoped_lock lock(Utils::registryMutex);
+    Utils::sumShards(snapshot.d->counters);
+    return snapshot;
+}
+
+void resetMetrics()
+{
+    boost::mutex::scoped_lock lock(Utils::registryMutex);
+    Utils::Counters current;
+    //The baseline is part of the sum
+    Utils::sumShards(current);
+    unsigned long *base = reinterpret_cast<unsigned long*>(&Utils::baseline.counters);
+    const unsigned long *values = reinterpret_cast<const unsigned long*>(&current);
+    const std::size_t count = sizeof(Utils::Counters) / sizeof(unsigned long);
+    for (std::size_t i = 0; i < count; i++) {
+        base[i] += values[i];
+    }
+}
+
+}
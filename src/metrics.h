@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2012  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstddef>
+#include "global_definitions.h"
+#include "instrumentation.h"
+#include "memoryaccounting.h"
+
+namespace Kolab {
+    namespace Utils {
+
+enum Operation {
+    ReadOperation,
+    WriteOperation
+};
+
+/**
+ * Accounts a read or write to the metrics and the memory accounting, reports it to the tracer,
+ * starts the clock of the time limit and sets the object type for the phase timers.
+ *
+ * The outcome (latency, error severity and size) is recorded when the scope ends,
+ * the counters are per thread so no locks are involved.
+ */
+class OperationScope
+{
+public:
+    OperationScope(Operation, ObjectType, std::size_t bytes = 0);
+    ~OperationScope();
+    void setBytes(std::size_t bytes);
+
+    /**
+     * Ends the memory accounting of the operation, true if it exceeded the memory budget, in which case the object is to be
+     * rejected. Called before the result is returned, so the tracer and the metrics see the failure.
+     */
+    bool exceedsMemoryBudget()
+    {
+        return mMemory.stop();
+    }
+
+    /**
+     * The object which is read or written, for the tracer.
+     */
+    template <typename T>
+    void setObject(const T &object)
+    {
+        mTrace.setObject(object);
+    }
+
+    /**
+     * The UID of the object just written, for the tracer.
+     */
+    void setCreatedUid()
+    {
+        mTrace.setCreatedUid();
+    }
+
+    /**
+     * The UID passed to the tracer (empty while not tracing).
+     */
+    const std::string &traceUid() const
+    {
+        return mTrace.uid();
+    }
+private:
+    OperationScope(const OperationScope &);
+    OperationScope &operator=(const OperationScope &);
+    ObjectTypeScope mObjectType;
+    MemoryScope mMemory;
+    TraceScope mTrace;
+    Operation mOperation;
+    ObjectType mType;
+    std::size_t mBytes;
+    unsigned long long mStart;
+};
+
+    }
+}
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2012  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "numericstrings.h"
+#include <climits>
+
+std::size_t formatInt(int value, char *buffer)
+{
+    // Work on the unsigned magnitude so INT_MIN doesn't overflow
+    unsigned int magnitude = value < 0 ? 0u - static_cast<unsigned int>(value) : static_cast<unsigned int>(value);
+    char digits[INT_STRING_SIZE];
+    std::size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+
+    std::size_t length = 0;
+    if (value < 0) {
+        buffer[length++] = '-';
+    }
+    while (count) {
+        buffer[length++] = digits[--count];
+    }
+    return length;
+}
+
+void appendInt(std::string &out, int value)
+{
+    char buffer[INT_STRING_SIZE];
+    out.append(buffer, formatInt(value, buffer));
+}
+
+const char *parseInt(const char *first, const char *last, int &value)
+{
+    const char *it = first;
+    bool negative = false;
+    if (it != last && (*it == '+' || *it == '-')) {
+        negative = (*it == '-');
+        ++it;
+    }
+    const char *digitsBegin = it;
+    // Accumulate negatively so INT_MIN can be represented
+    int result = 0;
+    for (; it != last && *it >= '0' && *it <= '9'; ++it) {
+        const int digit = *it - '0';
+        if (result < (INT_MIN + digit) / 10) {
+            return first;
+        }
+        result = result * 10 - digit;
+    }
+    if (it == digitsBegin) {
+        return first;
+    }
+    if (!negative) {
+        if (result == INT_MIN) {
+            return first;
+        }
+        result = -result;
+    }
+    value = result;
+    return it;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2012  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NUMERICSTRINGS_H
+#define NUMERICSTRINGS_H
+
+#include <string>
+#include <cstddef>
+
+/**
+ * Integer conversions for the numeric parts of the format (durations, recurrence positions, ...)
+ *
+ * These work on plain character ranges, so unlike lexical_cast they neither allocate nor throw.
+ */
+
+/**
+ * Size of a buffer that fits any int, including the sign (no terminating null is written).
+ */
+#define INT_STRING_SIZE 11
+
+/**
+ * Writes the decimal representation of value to buffer and returns the number of characters written.
+ */
+std::size_t formatInt(int value, char *buffer);
+
+/**
+ * Appends the decimal representation of value to out.
+ */
+void appendInt(std::string &out, int value);
+
+/**
+ * Parses an optionally signed ("+" or "-") decimal integer at the beginning of [first, last).
+ *
+ * Returns a pointer past the last parsed character, or first if no number could be parsed
+ * (no digits or out of range), in which case value is left untouched.
+ * Check the returned pointer against last to require the whole range to be a number.
+ */
+const char *parseInt(const char *first, const char *last, int &value);
+
+#endif
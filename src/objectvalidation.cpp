@@ -24,6 +24,7 @@
 #include "kolabconfiguration.h"
 #include "kolabfile.h"
 #include "utils.h"
+#include "instrumentation.h"
 #include "tztable.h"
 #include <boost/unordered_set.hpp>
 
@@ -47,11 +48,11 @@ bool isValid(const cDateTime &datetime)
     const std::string tz = datetime.timezone();
     if (!tz.empty()) {
         if (datetime.isUTC() && !tz.empty()) {
-            Utils::logMessage("A UTC datetime may not have a timezone", "", 0, Error);
+            Utils::logMessage("A UTC datetime may not have a timezone", "", 0, Error, ValidationError);
             return false;
         }
         if (tzSet.find(tz) == tzSet.end()) {
-            Utils::logMessage("Not a valid olson timezone: " + tz, "", 0, Error);
+            Utils::logMessage("Not a valid olson timezone: " + tz, "", 0, Error, ValidationError);
             return false;
         }
     }
@@ -61,33 +62,34 @@ bool isValid(const cDateTime &datetime)
 #define ASSERT(arg) \
     do {\
         if ( !(arg) ) { \
-            Utils::logMessage(#arg " is false", __FILE__, __LINE__, Error); \
+            Utils::logMessage(#arg " is false", __FILE__, __LINE__, Error, ValidationError); \
         } \
     } while(0)
 
 #define ASSERTEQUAL(arg1, arg2) \
     do {\
         if ( (arg1) != (arg2) ) { \
-            Utils::logMessage(#arg1 " != " #arg2, __FILE__, __LINE__, Error); \
+            Utils::logMessage(#arg1 " != " #arg2, __FILE__, __LINE__, Error, ValidationError); \
         } \
     } while(0)
 
 #define ASSERTEXISTING(arg) \
     do {\
         if ( !(arg).isValid() ) { \
-            Utils::logMessage(#arg " is not set", __FILE__, __LINE__, Error); \
+            Utils::logMessage(#arg " is not set", __FILE__, __LINE__, Error, ValidationError); \
         } \
     } while(0)
 
 #define ASSERTVALID(arg) \
     do {\
         if ( (arg).isValid() && !isValid((arg)) ) { \
-            Utils::logMessage(#arg " is not valid", __FILE__, __LINE__, Error); \
+            Utils::logMessage(#arg " is not valid", __FILE__, __LINE__, Error, ValidationError); \
         } \
     } while(0)
 
 void validate(const Event &event)
 {
+    Utils::PhaseTimer timer(ValidatePhase);
     ASSERTEXISTING(event.start());
     ASSERTVALID(event.start());
     ASSERTVALID(event.end());
@@ -98,6 +100,7 @@ void validate(const Event &event)
 
 void validate(const Todo& todo)
 {
+    Utils::PhaseTimer timer(ValidatePhase);
     ASSERTVALID(todo.start());
     ASSERTVALID(todo.due());
     if (todo.start().isValid() && todo.due().isValid()) {
@@ -107,6 +110,7 @@ void validate(const Todo& todo)
 
 void validate(const Journal& journal)
 {
+    Utils::PhaseTimer timer(ValidatePhase);
     ASSERTVALID(journal.start());
 }
 
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2012  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resourcelimits.h"
+#include "instrumentation.h"
+#include "utils.h"
+#include "numericstrings.h"
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <climits>
+
+namespace Kolab {
+    namespace Utils {
+
+static ResourceLimits limits;
+
+struct ResourceClock {
+    ResourceClock(): deadline(0) {};
+    //0 if there is no time limit
+    unsigned long long deadline;
+};
+
+static boost::thread_specific_ptr<ResourceClock> clockPtr;
+
+static ResourceClock &resourceClock()
+{
+    ResourceClock *c = clockPtr.get();
+    if (!c) {
+        c = new ResourceClock();
+        clockPtr.reset(c);
+    }
+    return *c;
+}
+
+void setResourceLimits(const ResourceLimits &l)
+{
+    limits = l;
+}
+
+const ResourceLimits &getResourceLimits()
+{
+    return limits;
+}
+
+void startResourceClock(unsigned long long start)
+{
+    if (limits.maxTime) {
+        resourceClock().deadline = start + static_cast<unsigned long long>(limits.maxTime) * 1000000ull;
+    } else if (clockPtr.get()) {
+        clockPtr->deadline = 0;
+    }
+}
+
+static bool exceeds(unsigned long long value, unsigned long limit, const char *what)
+{
+    if (!limit || value <= limit) {
+        return false;
+    }
+    std::string message(what);
+    message.append(" exceeds the limit of ");
+    appendInt(message, static_cast<int>(std::min(limit, static_cast<unsigned long>(INT_MAX))));
+    logMessage(message, __FILE__, __LINE__, Critical, ResourceLimitError);
+    return true;
+}
+
+bool exceedsInputSize(std::size_t size)
+{
+    return exceeds(size, limits.maxInputSize, "document size");
+}
+
+bool exceedsElementCount(unsigned long count)
+{
+    return exceeds(count, limits.maxElementCount, "element count");
+}
+
+bool exceedsAttachmentSize(std::size_t size)
+{
+    return exceeds(size, limits.maxAttachmentSize, "attachment size");
+}
+
+bool exceedsExceptionCount(std::size_t count)
+{
+    return exceeds(count, limits.maxExceptions, "number of exceptions");
+}
+
+bool exceedsTime()
+{
+    if (!limits.maxTime || !clockPtr.get() || !clockPtr->deadline) {
+        return false;
+    }
+    if (monotonicTime() <= clockPtr->deadline) {
+        return false;
+    }
+    std::string message("time exceeds the limit of ");
+    appendInt(message, static_cast<int>(std::min(limits.maxTime, static_cast<unsigned long>(INT_MAX))));
+    message.append("ms");
+    logMessage(message, __FILE__, __LINE__, Critical, ResourceLimitError);
+    return true;
+}
+
+    }
+}
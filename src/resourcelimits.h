@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2012  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCELIMITS_H
+#define RESOURCELIMITS_H
+
+#include <cstddef>
+#include "global_definitions.h"
+
+namespace Kolab {
+    namespace Utils {
+
+/**
+ * Process-wide limits for the reads and writes, see Kolab::setResourceLimits().
+ */
+void setResourceLimits(const ResourceLimits &);
+const ResourceLimits &getResourceLimits();
+
+/**
+ * Starts the clock for the time limit of the calling thread's operation (start is a monotonicTime()).
+ */
+void startResourceClock(unsigned long long start);
+
+/**
+ * The checks return true if the limit is exceeded, in which case a critical ResourceLimitError has been logged
+ * and the caller is expected to abort.
+ *
+ * Within the conversions the object is rejected as a whole by throwing ResourceLimitExceeded,
+ * which the deserialize functions catch to return an empty result.
+ */
+bool exceedsInputSize(std::size_t size);
+bool exceedsElementCount(unsigned long count);
+bool exceedsAttachmentSize(std::size_t size);
+bool exceedsExceptionCount(std::size_t count);
+bool exceedsTime();
+
+class ResourceLimitExceeded {};
+
+    }
+}
+
+#endif
@@ -22,6 +22,9 @@
 #include "kolabcontainers.h"
 #include <boost/shared_ptr.hpp>
 #include "utils.h"
+#include "enumstrings.h"
+#include "instrumentation.h"
+#include "resourcelimits.h"
 #include <bindings/iCalendar-params.hxx>
 
 namespace Kolab {
@@ -74,28 +77,40 @@ date fromDate(const cDateTime &d)
     return de;
 }
 
+const char * const URN_UUID = "urn:uuid:";
+const std::size_t URN_UUID_LENGTH = 9;
+
+bool isURN(const std::string &uri)
+{
+    return !uri.compare(0, URN_UUID_LENGTH, URN_UUID);
+}
+
 std::string toURN(const std::string &uid)
 {
-    if (uid.substr(0, 9) == std::string("urn:uuid:")) {
+    if (isURN(uid)) {
         return uid;
     }
-    return std::string("urn:uuid:")+uid;
+    std::string urn;
+    urn.reserve(URN_UUID_LENGTH + uid.size());
+    urn.append(URN_UUID, URN_UUID_LENGTH);
+    urn.append(uid);
+    return urn;
 }
 
 std::string fromURN(const std::string &uri)
 {
-    if (uri.substr(0, 9) != std::string("urn:uuid:")) {
+    if (!isURN(uri)) {
         LOG("not a urn");
         return uri;
     }
-    return uri.substr(9);
+    return uri.substr(URN_UUID_LENGTH);
 }
 
 Kolab::ContactReference toContactReference(const std::string &uri) {
-    std::string name;
-    if (uri.substr(0, 9) == std::string("urn:uuid:")) {
-        return Kolab::ContactReference(Kolab::ContactReference::UidReference, fromURN(uri));
+    if (isURN(uri)) {
+        return Kolab::ContactReference(Kolab::ContactReference::UidReference, uri.substr(URN_UUID_LENGTH));
     }
+    std::string name;
     const std::string &email = fromMailto(uri, name);
     return Kolab::ContactReference(Kolab::ContactReference::EmailReference, email, name);
 }
@@ -15,32 +15,115 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <curl/curl.h>
-#include <string>
+#include "uriencode.h"
+#include <cstring>
 
-std::string uriEncode(const std::string &s)
+/**
+ * Character classes for percent-encoding.
+ *
+ * We used to use libcurl for this, the output is identical to curl_easy_escape/curl_easy_unescape
+ * (of curl >= 7.26, older versions also encoded unreserved characters).
+ */
+class UriCharTable
 {
-    CURL *easyhandle = curl_easy_init();
-    char *result = curl_easy_escape(easyhandle, s.c_str(), static_cast<int>(s.length()));
-    curl_easy_cleanup(easyhandle);
-    if (!result) {
-        return std::string();
+public:
+    UriCharTable()
+    {
+        for (int c = 0; c < 256; c++) {
+            unreserved[c] = ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_' || c == '~');
+            if (c >= '0' && c <= '9') {
+                hexValue[c] = static_cast<signed char>(c - '0');
+            } else if (c >= 'A' && c <= 'F') {
+                hexValue[c] = static_cast<signed char>(c - 'A' + 10);
+            } else if (c >= 'a' && c <= 'f') {
+                hexValue[c] = static_cast<signed char>(c - 'a' + 10);
+            } else {
+                hexValue[c] = -1;
+            }
+        }
+    }
+    bool unreserved[256];
+    signed char hexValue[256];
+};
+
+static const UriCharTable charTable;
+static const char hexDigits[] = "0123456789ABCDEF";
+
+void uriEncodeAppend(std::string &out, const char *s, std::size_t len)
+{
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(s);
+    std::size_t escaped = 0;
+    for (std::size_t i = 0; i < len; i++) {
+        if (!charTable.unreserved[in[i]]) {
+            escaped++;
+        }
+    }
+    if (!escaped) {
+        out.append(s, len);
+        return;
+    }
+
+    const std::size_t pos = out.size();
+    out.resize(pos + len + 2 * escaped);
+    char *dest = &out[0] + pos;
+    for (std::size_t i = 0; i < len; i++) {
+        const unsigned char c = in[i];
+        if (charTable.unreserved[c]) {
+            *dest++ = static_cast<char>(c);
+        } else {
+            *dest++ = '%';
+            *dest++ = hexDigits[c >> 4];
+            *dest++ = hexDigits[c & 0xf];
+        }
     }
-    const std::string r(result);
-    curl_free(result);
-    return r;
 }
 
-std::string uriDecode(const std::string &s)
+void uriDecodeAppend(std::string &out, const char *s, std::size_t len)
 {
-    CURL *easyhandle = curl_easy_init();
-    int length = 0;
-    char *result = curl_easy_unescape(easyhandle, s.c_str(), static_cast<int>(s.length()), &length);
-    curl_easy_cleanup(easyhandle);
-    if (!length) {
-        return std::string();
+    const char *percent = static_cast<const char*>(std::memchr(s, '%', len));
+    if (!percent) {
+        out.append(s, len);
+        return;
     }
-    const std::string r(result, length);
-    curl_free(result);
-    return r;
+
+    const std::size_t pos = out.size();
+    out.resize(pos + len);
+    char *dest = &out[0] + pos;
+    const char *end = s + len;
+    while (percent) {
+        std::memcpy(dest, s, static_cast<std::size_t>(percent - s));
+        dest += percent - s;
+        s = percent;
+        //Only complete escape sequences are decoded, everything else is taken as is
+        if (end - s >= 3) {
+            const signed char high = charTable.hexValue[static_cast<unsigned char>(s[1])];
+            const signed char low = charTable.hexValue[static_cast<unsigned char>(s[2])];
+            if (high >= 0 && low >= 0) {
+                *dest++ = static_cast<char>((high << 4) | low);
+                s += 3;
+            } else {
+                *dest++ = *s++;
+            }
+        } else {
+            *dest++ = *s++;
+        }
+        percent = static_cast<const char*>(std::memchr(s, '%', static_cast<std::size_t>(end - s)));
+    }
+    std::memcpy(dest, s, static_cast<std::size_t>(end - s));
+    dest += end - s;
+    out.resize(static_cast<std::size_t>(dest - out.data()));
+}
+
+std::string uriEncode(const std::string &s)
+{
+    std::string result;
+    uriEncodeAppend(result, s.data(), s.size());
+    return result;
+}
+
+std::string uriDecode(const std::string &s)
+{
+    std::string result;
+    uriDecodeAppend(result, s.data(), s.size());
+    return result;
 }
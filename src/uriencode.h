@@ -19,11 +19,21 @@
 #define URIENCODE_H
 
 #include <string>
+#include <cstddef>
 
 /**
  * Url encoding according to RFC 3986 (used for mailto encoding)
+ *
+ * All characters but the unreserved ones (ALPHA / DIGIT / "-" / "." / "_" / "~") are percent-encoded.
+ * Decoding accepts any percent-encoded character, so older encoders which also encoded "." and "_" are understood.
  */
 std::string uriEncode(const std::string &s);
 std::string uriDecode(const std::string &s);
 
+/**
+ * Appends the encoded/decoded form to out, which is grown at most once.
+ */
+void uriEncodeAppend(std::string &out, const char *s, std::size_t len);
+void uriDecodeAppend(std::string &out, const char *s, std::size_t len);
+
 #endif
\ No newline at end of file
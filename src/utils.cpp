@@ -29,11 +29,17 @@
 #include <uuid.h>
 #endif
 
-#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread.hpp>
 #include <time.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#include <map>
+#include <algorithm>
 #include "base64.h"
 #include "uriencode.h"
+#include "numericstrings.h"
 #include "libkolabxml-version.h"
 
 namespace Kolab {
@@ -51,7 +57,23 @@ struct Global {
     
     ErrorSeverity errorBit;
     std::string errorMessage;
+    std::vector<Diagnostic> diagnostics;
     cDateTime overrideTimestamp;
+    TimestampProvider timestampProvider;
+    //The system time is only converted once per second
+    time_t cachedTime;
+    cDateTime cachedTimestamp;
+
+#if BOOST_VERSION >= 104300
+    //Created on first use, seeding it is expensive
+    boost::scoped_ptr<boost::uuids::random_generator> uuidGenerator;
+    //A generator inherited from the parent process would generate the same uids as the parent
+    unsigned int uuidForkGeneration;
+#endif
+
+    int mailtoCacheScopes;
+    //uri => (email, name)
+    std::map<std::string, std::pair<std::string, std::string> > mailtoCache;
 };
 
 boost::thread_specific_ptr<Global> ptr;
@@ -113,25 +135,19 @@ std::string createdUid()
 }
 
 
-std::string getUID(const std::string &s)
+#if BOOST_VERSION >= 104300
+static std::string generateUID(Global &global)
 {
-    if (!s.empty()) {
-        return s;
+    if (!global.uuidGenerator || global.uuidForkGeneration != forkGeneration()) {
+        global.uuidGenerator.reset(new boost::uuids::random_generator());
+        global.uuidForkGeneration = forkGeneration();
     }
-#if BOOST_VERSION >= 104300
-
-    //Required because boost::uuids::uuid is implemented as POD type
-    class uuid_class : public boost::uuids::uuid
-    {
-    public:
-        uuid_class()
-            : boost::uuids::uuid(boost::uuids::random_generator()())
-        {}
-    };
-
-    uuid_class u; // initialize uuid
-    return  boost::uuids::to_string(u);
+    const boost::uuids::uuid u = (*global.uuidGenerator)();
+    return boost::uuids::to_string(u);
+}
 #else
+static std::string generateUID(Global &)
+{
     uuid_t *uuid;
     //to avoid the "dereferencing type-punned pointer will break strict-aliasing rules" warning
     char * __attribute__((__may_alias__)) str = 0;
@@ -141,16 +157,95 @@ std::string getUID(const std::string &s)
     uuid_destroy(uuid);
 
     return std::string(str, 36); //We don't need the terminating \0
+}
+#endif
+
+static std::vector<boost::mutex*> &forkProtectedMutexes()
+{
+    static std::vector<boost::mutex*> mutexes;
+    return mutexes;
+}
+
+static unsigned int generation = 0;
+
+static void lockBeforeFork()
+{
+    std::vector<boost::mutex*> &mutexes = forkProtectedMutexes();
+    for (std::vector<boost::mutex*>::const_iterator it = mutexes.begin(); it != mutexes.end(); ++it) {
+        (*it)->lock();
+    }
+}
+
+static void unlockAfterFork()
+{
+    std::vector<boost::mutex*> &mutexes = forkProtectedMutexes();
+    for (std::vector<boost::mutex*>::const_reverse_iterator it = mutexes.rbegin(); it != mutexes.rend(); ++it) {
+        (*it)->unlock();
+    }
+}
+
+static void unlockInChild()
+{
+    //Only the forking thread exists in the child
+    generation++;
+    unlockAfterFork();
+}
+
+bool protectAcrossFork(boost::mutex &mutex)
+{
+#ifndef _WIN32
+    //Registered once, the mutexes are registered during static initialization (before any thread can fork)
+    static const int registered = pthread_atfork(&lockBeforeFork, &unlockAfterFork, &unlockInChild);
+    if (registered) {
+        return false;
+    }
 #endif
+    forkProtectedMutexes().push_back(&mutex);
+    return true;
+}
+
+unsigned int forkGeneration()
+{
+    return generation;
+}
+
+std::string getUID(const std::string &s)
+{
+    if (!s.empty()) {
+        return s;
+    }
+    return generateUID(ThreadLocal::inst());
+}
+
+std::vector<std::string> getUIDs(int count)
+{
+    std::vector<std::string> uids;
+    if (count <= 0) {
+        return uids;
+    }
+    Global &global = ThreadLocal::inst();
+    uids.reserve(static_cast<std::size_t>(count));
+    for (int i = 0; i < count; i++) {
+        uids.push_back(generateUID(global));
+    }
+    return uids;
 }
 
 cDateTime getCurrentTime()
 {
-    time_t rawtime;
-    struct tm * ptm;
-    time(&rawtime);
-    ptm = gmtime(&rawtime);
-    return cDateTime(ptm->tm_year+1900, ptm->tm_mon+1, ptm->tm_mday, ptm->tm_hour, ptm->tm_min, ptm->tm_sec, true);
+    Global &global = ThreadLocal::inst();
+    const time_t rawtime = time(0);
+    if (rawtime != global.cachedTime || !global.cachedTimestamp.isValid()) {
+        struct tm t;
+#ifdef _WIN32
+        gmtime_s(&t, &rawtime);
+#else
+        gmtime_r(&rawtime, &t);
+#endif
+        global.cachedTimestamp = cDateTime(t.tm_year+1900, t.tm_mon+1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec, true);
+        global.cachedTime = rawtime;
+    }
+    return global.cachedTimestamp;
 }
 
 void setOverrideTimestamp(const cDateTime &dt)
@@ -158,57 +253,120 @@ void setOverrideTimestamp(const cDateTime &dt)
     ThreadLocal::inst().overrideTimestamp = dt;
 }
 
+void setTimestampProvider(TimestampProvider provider)
+{
+    ThreadLocal::inst().timestampProvider = provider;
+}
+
 cDateTime timestamp()
 {
-    const cDateTime &dt = ThreadLocal::inst().overrideTimestamp;
-    if (dt.isValid()) {
-        LOG("Timestamp overridden"); 
-        return dt;
+    const Global &global = ThreadLocal::inst();
+    if (global.overrideTimestamp.isValid()) {
+        return global.overrideTimestamp;
+    }
+    if (global.timestampProvider) {
+        return global.timestampProvider();
     }
     return getCurrentTime();
 }
 
 
 
-void logMessage(const std::string &m, ErrorSeverity s)
+static LogHandler logHandler = &defaultLogHandler;
+static ErrorSeverity logThreshold = NoError;
+
+void setLogHandler(LogHandler handler)
+{
+    logHandler = handler;
+}
+
+void setLogThreshold(ErrorSeverity s)
+{
+    logThreshold = s;
+}
+
+void defaultLogHandler(ErrorSeverity s, const std::string &m)
 {
     switch (s) {
         case NoError:
-            std::cout << "Debug: " << m << std::endl;
+            std::cout << "Debug: " << m << '\n';
             break;
         case Warning:
-            std::cerr << "Warning: " << m << std::endl;
-            if (ThreadLocal::inst().errorBit < Warning) {
-                ThreadLocal::inst().errorBit = Warning;
-                ThreadLocal::inst().errorMessage = m;
-            }
+            std::cerr << "Warning: " << m << '\n';
             break;
         case Error:
-            std::cerr << "Error: " << m << std::endl;
-            if (ThreadLocal::inst().errorBit < Error) {
-                ThreadLocal::inst().errorBit = Error;
-                ThreadLocal::inst().errorMessage = m;
-            }
+            std::cerr << "Error: " << m << '\n';
             break;
         case Critical:
         default:
-            std::cerr << "Critical: " << m << std::endl;
-            if (ThreadLocal::inst().errorBit < Critical) {
-                ThreadLocal::inst().errorBit = Critical;
-                ThreadLocal::inst().errorMessage = m;
-            }
+            std::cerr << "Critical: " << m << '\n';
+    }
+}
+
+bool isLogged(ErrorSeverity s)
+{
+    return s != NoError || (logHandler && s >= logThreshold);
+}
+
+void logMessage(const std::string &m, ErrorSeverity s)
+{
+    if (s != NoError) {
+        Global &global = ThreadLocal::inst();
+        if (global.errorBit < s) {
+            global.errorBit = s;
+            global.errorMessage = m;
+        }
+    }
+    if (logHandler && s >= logThreshold) {
+        logHandler(s, m);
     }
 }
 
-void logMessage(const std::string &message, const std::string &file, int line, ErrorSeverity s)
+void logMessage(const std::string &message, const std::string &file, int line, ErrorSeverity s, DiagnosticCode code)
 {
-   logMessage(file+" "+boost::lexical_cast<std::string>(line)+": " + "  " + message, s);
+    if (s != NoError) {
+        ThreadLocal::inst().diagnostics.push_back(Diagnostic(s, code, message));
+    } else if (!isLogged(s)) {
+        return;
+    }
+    static const char separator[] = ":   ";
+    std::string m;
+    m.reserve(file.size() + 1 + INT_STRING_SIZE + sizeof(separator) - 1 + message.size());
+    m.append(file);
+    m.push_back(' ');
+    appendInt(m, line);
+    m.append(separator, sizeof(separator) - 1);
+    m.append(message);
+    logMessage(m, s);
+}
+
+void logDiagnostic(const Diagnostic &d)
+{
+    if (d.severity != NoError) {
+        ThreadLocal::inst().diagnostics.push_back(d);
+    } else if (!isLogged(d.severity)) {
+        return;
+    }
+    if (!d.line) {
+        logMessage(d.message, d.severity);
+        return;
+    }
+    std::string m;
+    m.reserve(2 * INT_STRING_SIZE + 3 + d.message.size());
+    appendInt(m, static_cast<int>(d.line));
+    m.push_back(':');
+    appendInt(m, static_cast<int>(d.column));
+    m.append(": ", 2);
+    m.append(d.message);
+    logMessage(m, d.severity);
 }
 
 void clearErrors()
 {
-    ThreadLocal::inst().errorBit = NoError;
-    ThreadLocal::inst().errorMessage.clear();
+    Global &global = ThreadLocal::inst();
+    global.errorBit = NoError;
+    global.errorMessage.clear();
+    global.diagnostics.clear();
 }
 
 ErrorSeverity getError()
@@ -221,68 +379,130 @@ std::string getErrorMessage()
     return ThreadLocal::inst().errorMessage;
 }
 
+const std::vector<Diagnostic> &getDiagnostics()
+{
+    return ThreadLocal::inst().diagnostics;
+}
+
 
 std::string uriInlineEncoding(const std::string &s, const std::string &mimetype)
 {
-    return std::string("data:")+mimetype+std::string(";base64,")+base64_encode(reinterpret_cast<const unsigned char*>(s.c_str()), static_cast<unsigned int>(s.length()));
+    static const char prefix[] = "data:";
+    static const char encoding[] = ";base64,";
+    std::string uri;
+    uri.reserve(sizeof(prefix) - 1 + mimetype.size() + sizeof(encoding) - 1 + base64_encoded_size(s.size()));
+    uri.append(prefix, sizeof(prefix) - 1);
+    uri.append(mimetype);
+    uri.append(encoding, sizeof(encoding) - 1);
+    base64_encode_append(uri, reinterpret_cast<const unsigned char*>(s.data()), s.size());
+    return uri;
 }
 
-std::string uriInlineDecoding(const std::string &s, std::string &mimetype)
+bool parseInlineDataUri(const std::string &s, InlineDataUri &parts)
 {
-    if (s.substr(0, 5) != std::string("data:")) {
+    if (s.compare(0, 5, "data:")) {
         ERROR("wrong picture encoding");
-        std::cout << s <<  "      " << s.substr(0, 5) << std::endl;
-        return std::string();
+        return false;
     }
-    std::size_t pos = s.find(";",5);
-    if (pos == std::string::npos) {
+    const std::size_t pos = s.find(';', 5);
+    if (pos == std::string::npos || s.compare(pos + 1, 6, "base64")) {
         ERROR("wrong picture encoding");
-        std::cout << s <<  "      " << s.substr(0, 5) << std::endl;
-        return std::string();
+        return false;
     }
-    mimetype = s.substr(5, pos-5);
-    if (s.substr(pos+1, 6) != std::string("base64")) {
-        ERROR("wrong picture encoding");
-        std::cout << s <<  "      " << s.substr(pos+1, 6) << std::endl;
-        return std::string();
+    parts.mimetypeBegin = 5;
+    parts.mimetypeLength = pos - 5;
+    parts.dataBegin = std::min(pos + 8, s.size());
+    return true;
+}
+
+bool inlineMimetypeEquals(const std::string &s, const InlineDataUri &parts, const char *mimetype)
+{
+    return !s.compare(parts.mimetypeBegin, parts.mimetypeLength, mimetype);
+}
+
+void inlineDecodeData(const std::string &s, const InlineDataUri &parts, std::string &data)
+{
+    data.clear();
+    base64_decode_append(data, s.data() + parts.dataBegin, s.size() - parts.dataBegin);
+}
+
+bool uriInlineSplit(const std::string &s, std::string &base64, std::string &mimetype)
+{
+    InlineDataUri parts;
+    if (!parseInlineDataUri(s, parts)) {
+        return false;
+    }
+    mimetype.assign(s, parts.mimetypeBegin, parts.mimetypeLength);
+    base64.assign(s, parts.dataBegin, std::string::npos);
+    return true;
+}
+
+std::string uriInlineDecoding(const std::string &s, std::string &mimetype)
+{
+    InlineDataUri parts;
+    std::string data;
+    if (!parseInlineDataUri(s, parts)) {
+        return data;
     }
-    return base64_decode(s.substr(pos+8, s.size()-(pos+8)));
+    mimetype.assign(s, parts.mimetypeBegin, parts.mimetypeLength);
+    inlineDecodeData(s, parts, data);
+    return data;
 }
 
 std::string toMailto(const std::string &email, const std::string &name)
 {
+    //Encodes "mailto:name<email>" directly into the result
     std::string mailto;
-    if (!name.empty()) {
-        mailto.append(name);
-    }
-    mailto.append("<");
-    mailto.append(email);
-    mailto.append(">");
-    return std::string("mailto:")+uriEncode(mailto);
+    mailto.reserve(7 + 3 * (name.size() + email.size() + 2));
+    mailto.append("mailto:");
+    uriEncodeAppend(mailto, name.data(), name.size());
+    mailto.append("%3C");
+    uriEncodeAppend(mailto, email.data(), email.size());
+    mailto.append("%3E");
+    return mailto;
 }
 
-std::string fromMailto(const std::string &mailtoUri, std::string &name)
+bool parseMailto(const std::string &mailtoUri, std::string &email, std::string &name)
 {
-    const std::string &decoded = uriDecode(mailtoUri);
-    if (decoded.substr(0, 7).compare("mailto:")) {
-        WARNING("no mailto address");
-        std::cout << decoded << std::endl;
-        return mailtoUri;
+    std::string decoded;
+    uriDecodeAppend(decoded, mailtoUri.data(), mailtoUri.size());
+    if (decoded.compare(0, 7, "mailto:")) {
+        return false;
     }
-    std::size_t begin = decoded.find('<',7);
+    const std::size_t begin = decoded.find('<', 7);
     if (begin == std::string::npos) {
-        WARNING("no mailto address");
-        std::cout << decoded << std::endl;
-        return mailtoUri;
+        return false;
     }
-    std::size_t end = decoded.find('>', begin);
+    const std::size_t end = decoded.find('>', begin);
     if (end == std::string::npos) {
+        return false;
+    }
+    name.assign(decoded, 7, begin - 7);
+    email.assign(decoded, begin + 1, end - begin - 1);
+    return true;
+}
+
+//Bounds the memory used for objects with huge lists of distinct references
+static const std::size_t maxMailtoCacheSize = 1024;
+
+std::string fromMailto(const std::string &mailtoUri, std::string &name)
+{
+    Global &global = ThreadLocal::inst();
+    if (global.mailtoCacheScopes) {
+        const std::map<std::string, std::pair<std::string, std::string> >::const_iterator it = global.mailtoCache.find(mailtoUri);
+        if (it != global.mailtoCache.end()) {
+            name = it->second.second;
+            return it->second.first;
+        }
+    }
+    std::string email;
+    if (!parseMailto(mailtoUri, email, name)) {
         WARNING("no mailto address");
-        std::cout << decoded << std::endl;
         return mailtoUri;
     }
-    name = decoded.substr(7, begin-7);
-    const std::string &email = decoded.substr(begin+1, end-begin-1);
+    if (global.mailtoCacheScopes && global.mailtoCache.size() < maxMailtoCacheSize) {
+        global.mailtoCache.insert(std::make_pair(mailtoUri, std::make_pair(email, name)));
+    }
     return email;
 }
 
@@ -292,6 +512,24 @@ std::string fromMailto(const std::string &mailtoUri)
     return fromMailto(mailtoUri, n);
 }
 
+MailtoCacheScope::MailtoCacheScope(bool enabled)
+:   mEnabled(enabled)
+{
+    if (mEnabled) {
+        ThreadLocal::inst().mailtoCacheScopes++;
+    }
+}
+
+MailtoCacheScope::~MailtoCacheScope()
+{
+    if (mEnabled) {
+        Global &global = ThreadLocal::inst();
+        if (!--global.mailtoCacheScopes) {
+            global.mailtoCache.clear();
+        }
+    }
+}
+
 std::string getProductId(const std::string& clientProdid)
 {
     if (clientProdid.empty()) {
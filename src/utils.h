@@ -19,9 +19,17 @@
 #define UTILS_H
 
 #include <string>
+#include <vector>
 #include "kolabcontainers.h"
 #include "global_definitions.h"
 #include <boost/numeric/conversion/cast.hpp>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace boost {
+    class mutex;
+}
 
 namespace Kolab {
 
@@ -31,15 +39,100 @@ namespace Kolab {
  */
 std::string getUID(const std::string & = std::string());
 
-void logMessage(const std::string &,const std::string &, int, ErrorSeverity s);
-     
-#define LOG(message) Utils::logMessage(message,__FILE__, __LINE__, NoError);
-#define WARNING(message) Utils::logMessage(message,__FILE__, __LINE__, Warning);
-#define ERROR(message) Utils::logMessage(message,__FILE__, __LINE__, Error);
-#define CRITICAL(message) Utils::logMessage(message,__FILE__, __LINE__, Critical);
+/**
+ * Returns count new globally unique UIDs.
+ */
+std::vector<std::string> getUIDs(int count);
+
+/**
+ * Keeps a process-wide mutex consistent across fork(): it is locked before forking and unlocked again in the parent
+ * and the child, so the child never inherits it locked by a thread which doesn't exist in the child.
+ *
+ * Meant for static mutexes: static const bool registered = protectAcrossFork(mutex);
+ */
+bool protectAcrossFork(boost::mutex &mutex);
+
+/**
+ * Incremented in the child on every fork(), so per-thread state which must not be shared with the parent
+ * (the state of the uuid generator) can be recreated.
+ */
+unsigned int forkGeneration();
+
+/**
+ * Atomically adds amount to value and returns the previous value.
+ *
+ * atomicAdd(value, 0) reads a value which is written by another thread.
+ */
+inline unsigned long atomicAdd(unsigned long &value, unsigned long amount)
+{
+#ifdef _MSC_VER
+    //unsigned long and long have the same size on windows
+    return static_cast<unsigned long>(_InterlockedExchangeAdd(reinterpret_cast<volatile long*>(&value), static_cast<long>(amount)));
+#else
+    return __sync_fetch_and_add(&value, amount);
+#endif
+}
+
+inline unsigned long long atomicAdd(unsigned long long &value, unsigned long long amount)
+{
+#ifdef _MSC_VER
+    //There is no 64 bit exchange-add intrinsic on x86
+    volatile __int64 *target = reinterpret_cast<volatile __int64*>(&value);
+    unsigned long long previous = static_cast<unsigned long long>(*target);
+    for (;;) {
+        const __int64 current = _InterlockedCompareExchange64(target, static_cast<__int64>(previous + amount), static_cast<__int64>(previous));
+        if (static_cast<unsigned long long>(current) == previous) {
+            return previous;
+        }
+        previous = static_cast<unsigned long long>(current);
+    }
+#else
+    return __sync_fetch_and_add(&value, amount);
+#endif
+}
+
+void logMessage(const std::string &,const std::string &, int, ErrorSeverity s, DiagnosticCode code = GenericError);
+
+/**
+ * Records a structured diagnostic (i.e. with the position in the document) and logs it.
+ */
+void logDiagnostic(const Diagnostic &);
+
+/**
+ * Returns true if a message of severity s is either passed on to the log handler or needed for the error state.
+ *
+ * The macros check this before the message is built, so disabled debug messages cost a comparison.
+ * Warnings and errors are always needed for the diagnostics list.
+ */
+bool isLogged(ErrorSeverity s);
+
+/**
+ * Debug messages can be stripped at compile time by defining KOLAB_NO_DEBUG_LOG (cmake -DDEBUG_LOGGING=FALSE).
+ *
+ * The macros expand to a block (including the trailing semicolon of the old versions), so they can be used with or without semicolon.
+ */
+#ifdef KOLAB_NO_DEBUG_LOG
+#define LOG(message) {}
+#else
+#define LOG(message) { if (Utils::isLogged(NoError)) { Utils::logMessage(message,__FILE__, __LINE__, NoError); } }
+#endif
+#define WARNING(message) { if (Utils::isLogged(Warning)) { Utils::logMessage(message,__FILE__, __LINE__, Warning); } }
+#define ERROR(message) { if (Utils::isLogged(Error)) { Utils::logMessage(message,__FILE__, __LINE__, Error); } }
+#define CRITICAL(message) { if (Utils::isLogged(Critical)) { Utils::logMessage(message,__FILE__, __LINE__, Critical); } }
 
 void logMessage(const std::string &, ErrorSeverity s = Warning);
 
+/**
+ * Receives all messages with a severity of at least the log threshold.
+ *
+ * The default handler prints to stdout (debug) and stderr, 0 disables the output.
+ * Both settings are process-wide, set them before using the library from several threads.
+ */
+typedef void (*LogHandler)(ErrorSeverity severity, const std::string &message);
+void setLogHandler(LogHandler);
+void defaultLogHandler(ErrorSeverity severity, const std::string &message);
+void setLogThreshold(ErrorSeverity);
+
 
 /**
  * The following values must be updated by the serialization/deserialization functions
@@ -52,6 +145,30 @@ void logMessage(const std::string &, ErrorSeverity s = Warning);
 void clearErrors();
 ErrorSeverity getError();
 std::string getErrorMessage();
+/**
+ * All warnings and errors since the last clearErrors(), in order of occurrence.
+ */
+const std::vector<Diagnostic> &getDiagnostics();
+
+/**
+ * Copies the diagnostics of the calling thread to target (unless it is 0) when it goes out of scope,
+ * so a read or write can hand out its diagnostics along with the result.
+ */
+class DiagnosticsOutput
+{
+public:
+    explicit DiagnosticsOutput(std::vector<Diagnostic> *target): mTarget(target) {}
+    ~DiagnosticsOutput()
+    {
+        if (mTarget) {
+            *mTarget = getDiagnostics();
+        }
+    }
+private:
+    DiagnosticsOutput(const DiagnosticsOutput &);
+    DiagnosticsOutput &operator=(const DiagnosticsOutput &);
+    std::vector<Diagnostic> *mTarget;
+};
 
 /**
  * The uid of the last serialized object
@@ -81,8 +198,17 @@ std::string xCalVersion();
  * A timestamp which overrides the one normally used.
  */
 void setOverrideTimestamp(const cDateTime &);
+
 /**
- * From system time or overrideTimestamp if set.
+ * A clock used instead of the system time (reset with 0).
+ */
+typedef cDateTime (*TimestampProvider)();
+void setTimestampProvider(TimestampProvider);
+
+/**
+ * From overrideTimestamp if set, the timestamp provider if set, or the system time.
+ *
+ * The system time is cached per second, so this is cheap to call for every write.
  */
 cDateTime timestamp();
 
@@ -123,10 +249,66 @@ T fromInt(int integer)
 std::string uriInlineEncoding(const std::string &, const std::string &mime);
 std::string uriInlineDecoding(const std::string &s, std::string &mimetype);
 
+/**
+ * The position of the parts of an inline "data:<mimetype>;base64,<data>" uri.
+ */
+struct InlineDataUri {
+    InlineDataUri(): mimetypeBegin(0), mimetypeLength(0), dataBegin(0) {}
+    std::size_t mimetypeBegin;
+    std::size_t mimetypeLength;
+    std::size_t dataBegin;
+};
+
+/**
+ * Locates mimetype and payload of an inline data uri without copying anything.
+ *
+ * Returns false (and sets an error) if the uri is not a base64 encoded inline data uri.
+ */
+bool parseInlineDataUri(const std::string &uri, InlineDataUri &);
+
+/**
+ * Compares the mimetype of a parsed inline data uri without extracting it.
+ */
+bool inlineMimetypeEquals(const std::string &uri, const InlineDataUri &, const char *mimetype);
+
+/**
+ * Decodes the payload of a parsed inline data uri into data (which is replaced).
+ */
+void inlineDecodeData(const std::string &uri, const InlineDataUri &, std::string &data);
+
+/**
+ * Splits an inline data uri into its mimetype and the still base64 encoded payload.
+ */
+bool uriInlineSplit(const std::string &uri, std::string &base64, std::string &mimetype);
+
 std::string toMailto(const std::string &email, const std::string &name = std::string());
 std::string fromMailto(const std::string &mailtoUri, std::string &name);
 std::string fromMailto(const std::string &mailtoUri);
 
+/**
+ * Decodes a "mailto:name<email>" uri.
+ *
+ * Returns false, without touching email or name, if the uri is not of that form.
+ */
+bool parseMailto(const std::string &mailtoUri, std::string &email, std::string &name);
+
+/**
+ * Memoizes the results of fromMailto while in scope (per thread).
+ *
+ * Exceptions usually repeat the organizer and attendees of the main event,
+ * so deserializing an event with exceptions would otherwise decode the same uris over and over.
+ */
+class MailtoCacheScope
+{
+public:
+    explicit MailtoCacheScope(bool enabled = true);
+    ~MailtoCacheScope();
+private:
+    MailtoCacheScope(const MailtoCacheScope &);
+    void operator=(const MailtoCacheScope &);
+    bool mEnabled;
+};
+
 /**
  * Appends the libkolabxml productid and returns the string
  */
@@ -32,6 +32,8 @@
 
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <climits>
 
 #include <boost/lexical_cast.hpp>
 
@@ -43,6 +45,7 @@
 #include "utils.h"
 #include "base64.h"
 #include "shared_conversions.h"
+#include "numericstrings.h"
 
 namespace Kolab {
     namespace XCAL {
@@ -56,33 +59,6 @@ const char* const THISANDFUTURE = "THISANDFUTURE";
 
 const char* const BASE64 = "BASE64";
 
-const char* const NEEDSACTION = "NEEDS-ACTION";
-const char* const COMPLETED = "COMPLETED";
-const char* const COMPLETED_COMPAT = "OPAQUE";
-const char* const INPROCESS = "IN-PROCESS";
-const char* const CANCELLED = "CANCELLED";
-const char* const TENTATIVE = "TENTATIVE";
-const char* const CONFIRMED = "CONFIRMED";
-const char* const DRAFT = "DRAFT";
-const char* const FINAL = "FINAL";
-
-const char* const CONFIDENTIAL = "CONFIDENTIAL";
-const char* const PRIVATE = "PRIVATE";
-const char* const PUBLIC = "PUBLIC";
-
-const char* const PARTACCEPTED = "ACCEPTED";
-const char* const PARTDECLINED = "DECLINED";
-const char* const PARTDELEGATED = "DELEGATED";
-const char* const PARTNEEDSACTION = "NEEDS-ACTION";
-const char* const PARTTENTATIVE = "TENTATIVE";
-const char* const PARTINPROCESS = "IN-PROCESS";
-const char* const PARTCOMPLETED = "COMPLETED";
-
-const char* const CHAIR = "CHAIR";
-const char* const NONPARTICIPANT = "NON-PARTICIPANT";
-const char* const OPTIONAL = "OPT-PARTICIPANT";
-const char* const REQUIRED = "REQ-PARTICIPANT";
-
 const char* const DISPLAYALARM = "DISPLAY";
 const char* const EMAILALARM = "EMAIL";
 const char* const AUDIOALARM = "AUDIO";
@@ -90,32 +66,72 @@ const char* const AUDIOALARM = "AUDIO";
 const char* const TRANSPARENT = "TRANSPARENT";
 const char* const OPAQUE = "OPAQUE";
 
-const char* const MO = "MO";
-const char* const TU = "TU";
-const char* const WE = "WE";
-const char* const TH = "TH";
-const char* const FR = "FR";
-const char* const SA = "SA";
-const char* const SU = "SU";
-
-const char* const GROUP = "GROUP";
-const char* const INDIVIDUAL = "INDIVIDUAL";
-const char* const RESOURCE = "RESOURCE";
-const char* const UNKNOWN = "UNKNOWN";
-const char* const ROOM = "ROOM";
-
 //Alarms
 const char* const START = "START";
 const char* const END = "END";
 
-//Freebusy
-const char* const BUSY = "BUSY";
-const char* const BUSY_TENTATIVE = "BUSY-TENTATIVE";
-const char* const BUSY_OUTOFOFFICE = "X-OUT-OF-OFFICE";
-
 using namespace Kolab::Utils;
 using namespace Kolab::Shared;
 
+const EnumString<Kolab::Status> statusStrings[] = {
+    ENUM_STRING(StatusNeedsAction, "NEEDS-ACTION"),
+    ENUM_STRING(StatusCompleted, "COMPLETED"),
+    ENUM_STRING(StatusCompleted, "OPAQUE"), //compatibility with old versions
+    ENUM_STRING(StatusInProcess, "IN-PROCESS"),
+    ENUM_STRING(StatusCancelled, "CANCELLED"),
+    ENUM_STRING(StatusTentative, "TENTATIVE"),
+    ENUM_STRING(StatusConfirmed, "CONFIRMED"),
+    ENUM_STRING(StatusDraft, "DRAFT"),
+    ENUM_STRING(StatusFinal, "FINAL")
+};
+
+const EnumString<Kolab::Classification> classificationStrings[] = {
+    ENUM_STRING(ClassPublic, "PUBLIC"),
+    ENUM_STRING(ClassPrivate, "PRIVATE"),
+    ENUM_STRING(ClassConfidential, "CONFIDENTIAL")
+};
+
+const EnumString<Kolab::PartStatus> partStatStrings[] = {
+    ENUM_STRING(PartAccepted, "ACCEPTED"),
+    ENUM_STRING(PartDeclined, "DECLINED"),
+    ENUM_STRING(PartDelegated, "DELEGATED"),
+    ENUM_STRING(PartNeedsAction, "NEEDS-ACTION"),
+    ENUM_STRING(PartTentative, "TENTATIVE"),
+    ENUM_STRING(PartInProcess, "IN-PROCESS"),
+    ENUM_STRING(PartCompleted, "COMPLETED")
+};
+
+const EnumString<Kolab::Role> roleStrings[] = {
+    ENUM_STRING(Chair, "CHAIR"),
+    ENUM_STRING(NonParticipant, "NON-PARTICIPANT"),
+    ENUM_STRING(Optional, "OPT-PARTICIPANT"),
+    ENUM_STRING(Required, "REQ-PARTICIPANT")
+};
+
+const EnumString<Kolab::Cutype> cutypeStrings[] = {
+    ENUM_STRING(CutypeIndividual, "INDIVIDUAL"),
+    ENUM_STRING(CutypeGroup, "GROUP"),
+    ENUM_STRING(CutypeResource, "RESOURCE"),
+    ENUM_STRING(CutypeRoom, "ROOM"),
+    ENUM_STRING(CutypeUnknown, "UNKNOWN")
+};
+
+const EnumString<Kolab::Weekday> weekdayStrings[] = {
+    ENUM_STRING(Kolab::Monday, "MO"),
+    ENUM_STRING(Kolab::Tuesday, "TU"),
+    ENUM_STRING(Kolab::Wednesday, "WE"),
+    ENUM_STRING(Kolab::Thursday, "TH"),
+    ENUM_STRING(Kolab::Friday, "FR"),
+    ENUM_STRING(Kolab::Saturday, "SA"),
+    ENUM_STRING(Kolab::Sunday, "SU")
+};
+
+const EnumString<Kolab::FreebusyPeriod::FBType> fbtypeStrings[] = {
+    ENUM_STRING(FreebusyPeriod::Busy, "BUSY"),
+    ENUM_STRING(FreebusyPeriod::Tentative, "BUSY-TENTATIVE"),
+    ENUM_STRING(FreebusyPeriod::OutOfOffice, "X-OUT-OF-OFFICE")
+};
+
 //=== Generic Conversions ===
     
 
@@ -147,131 +163,77 @@ std::string toString(const icalendar_2_0::TextPropertyType &s)
 
 std::string fromDayPos(const Kolab::DayPos &d)
 {   
-    std::string s;
+    char buffer[INT_STRING_SIZE + 2];
+    std::size_t length = 0;
     if (d.occurence() != 0) {
-        s.append(boost::lexical_cast<std::string>(d.occurence()));
-    }
-    switch (d.weekday()) {
-        case Kolab::Monday:
-            s.append(MO);
-            break;
-        case Kolab::Tuesday:
-            s.append(TU);
-            break;
-        case Kolab::Wednesday:
-            s.append(WE);
-            break;
-        case Kolab::Thursday:
-            s.append(TH);
-            break;
-        case Kolab::Friday:
-            s.append(FR);
-            break;
-        case Kolab::Saturday:
-            s.append(SA);
-            break;
-        case Kolab::Sunday:
-            s.append(SU);
-            break;
-    }
-    return s;
+        length = formatInt(d.occurence(), buffer);
+    }
+    const EnumString<Kolab::Weekday> *weekday = findEnumString(weekdayStrings, d.weekday());
+    if (weekday) {
+        std::copy(weekday->string, weekday->string + weekday->length, buffer + length);
+        length += weekday->length;
+    }
+    return std::string(buffer, length);
 }
 
 Kolab::DayPos toDayPos(const std::string &s)
 {
-    std::string number;
-    bool gotOccurrence = false;
+    const char *begin = s.data();
+    const char *end = begin + s.size();
+
+    //The occurrence is everything up to the first character which isn't part of a number
+    const char *weekdayBegin = begin;
+    while (weekdayBegin != end && ((*weekdayBegin >= '0' && *weekdayBegin <= '9') || *weekdayBegin == '+' || *weekdayBegin == '-')) {
+        ++weekdayBegin;
+    }
     int occurrence = 0;
-    for (std::string::const_iterator it = s.begin(); it != s.end(); it++) {
-        switch(*it) {
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-            case '+':
-            case '-':
-                number.push_back(*it);
-                break;
-            default:
-                if (!gotOccurrence && !number.empty()) {
-                    try {
-                        occurrence = boost::lexical_cast<int>(number);
-                    } catch(boost::bad_lexical_cast &) {
-                        ERROR("failed to convert: " + number);
-                        return DayPos();
-                    }
-                    number.clear();
-                }
-                gotOccurrence = true;
-                number.push_back(*it);
-                break;
+    if (weekdayBegin != begin && weekdayBegin != end) {
+        if (parseInt(begin, weekdayBegin, occurrence) != weekdayBegin) {
+            ERROR("failed to convert: " + std::string(begin, weekdayBegin));
+            return DayPos();
         }
     }
 
-    if (number == MO) {
-        return DayPos(occurrence, Kolab::Monday);
-    } else if (number == TU) {
-        return DayPos(occurrence, Kolab::Tuesday);
-    } else if (number == WE) {
-        return DayPos(occurrence, Kolab::Wednesday);
-    } else if (number == TH) {
-        return DayPos(occurrence, Kolab::Thursday);
-    } else if (number == FR) {
-        return DayPos(occurrence, Kolab::Friday);
-    } else if (number == SA) {
-        return DayPos(occurrence, Kolab::Saturday);
-    } else if (number == SU) {
-        return DayPos(occurrence, Kolab::Sunday);
+    const EnumString<Kolab::Weekday> *weekday = findEnumString(weekdayStrings, weekdayBegin, static_cast<std::size_t>(end - weekdayBegin));
+    if (weekday) {
+        return DayPos(occurrence, weekday->value);
     }
     return DayPos();
 }
 
+    /**
+     * Appends value followed by the designator if value is > 0
+     */
+    static char *appendDurationValue(char *out, int value, char designator)
+    {
+        if (value > 0) {
+            out += formatInt(value, out);
+            *out++ = designator;
+        }
+        return out;
+    }
+
 std::string fromDuration(const Kolab::Duration &d)
 {
-    std::string s;
     if (!d.isValid()) {
-        return s;
-    }
-    if (d.isNegative()) {
-        s.push_back('-');
-    }
-    s.push_back('P');
-    try {
-        if (d.weeks() > 0) {
-            s.append(boost::lexical_cast<std::string>(d.weeks()));
-            s.push_back('W');
-        }
-        if (d.days() > 0) {
-            s.append(boost::lexical_cast<std::string>(d.days()));
-            s.push_back('D');
-        }
-        if (d.hours() > 0 || d.minutes() > 0 || d.seconds() > 0) {
-            s.push_back('T');
-            if (d.hours() > 0) {
-                s.append(boost::lexical_cast<std::string>(d.hours()));
-                s.push_back('H');
-            }
-            if (d.minutes() > 0) {
-                s.append(boost::lexical_cast<std::string>(d.minutes()));
-                s.push_back('M');
-            }
-            if (d.seconds() > 0) {
-                s.append(boost::lexical_cast<std::string>(d.seconds()));
-                s.push_back('S');
-            }
-        }
-        
-    } catch(boost::bad_lexical_cast &) { 
-        ERROR("failed to convert duration");
         return std::string();
     }
-    return s;
+    //Sign, "P", "T" and five values with designator
+    char buffer[3 + 5 * (INT_STRING_SIZE + 1)];
+    char *out = buffer;
+    if (d.isNegative()) {
+        *out++ = '-';
+    }
+    *out++ = 'P';
+    out = appendDurationValue(out, d.weeks(), 'W');
+    out = appendDurationValue(out, d.days(), 'D');
+    if (d.hours() > 0 || d.minutes() > 0 || d.seconds() > 0) {
+        *out++ = 'T';
+        out = appendDurationValue(out, d.hours(), 'H');
+        out = appendDurationValue(out, d.minutes(), 'M');
+        out = appendDurationValue(out, d.seconds(), 'S');
+    }
+    return std::string(buffer, out);
 }
 
 Kolab::Duration toDuration(const icalendar_2_0::DurationValueType &d)
@@ -283,9 +245,13 @@ Kolab::Duration toDuration(const icalendar_2_0::DurationValueType &d)
     int seconds = 0;
     bool negative = false;
 
-    std::string number;
+    //The digits preceding a designator, accumulated on the fly (digits separated by 'T', 'P' or '+' are concatenated)
+    int number = 0;
+    bool gotNumber = false;
+    bool overflow = false;
 
     for (std::string::const_iterator it = d.begin(); it != d.end(); it++) {
+        int *value = 0;
         switch(*it) {
             case '0':
             case '1':
@@ -296,66 +262,52 @@ Kolab::Duration toDuration(const icalendar_2_0::DurationValueType &d)
             case '6':
             case '7':
             case '8':
-            case '9':
-                number.push_back(*it);
-                break;
-            case 'H':
-                try {
-                    hours = boost::lexical_cast<int>(number);
-                } catch(boost::bad_lexical_cast &) {
-                    ERROR("failed to convert: " +  number);
-                    return Duration();
+            case '9': {
+                const int digit = *it - '0';
+                if (number > (INT_MAX - digit) / 10) {
+                    overflow = true;
+                } else {
+                    number = number * 10 + digit;
                 }
-                number.clear();
+                gotNumber = true;
+                continue;
+            }
+            case 'H':
+                value = &hours;
                 break;
             case 'M':
-                try {
-                    minutes = boost::lexical_cast<int>(number);
-                } catch(boost::bad_lexical_cast &) {
-                    ERROR("failed to convert: " + number);
-                    return Duration();
-                }
-                number.clear();
+                value = &minutes;
                 break;
             case 'S':
-                try {
-                    seconds = boost::lexical_cast<int>(number);
-                } catch(boost::bad_lexical_cast &) { 
-                    ERROR("failed to convert: " + number);
-                    return Duration();
-                }
-                number.clear();
-                break;
-            case 'T':
+                value = &seconds;
                 break;
             case 'W':
-                try {
-                    weeks = boost::lexical_cast<int>(number);
-                } catch(boost::bad_lexical_cast &) { 
-                    ERROR("failed to convert: " + number);
-                    return Duration();
-                }
-                return Duration(weeks, negative);
+                value = &weeks;
+                break;
             case 'D':
-                try {
-                    days = boost::lexical_cast<int>(number);
-                } catch(boost::bad_lexical_cast &) { 
-                    ERROR("failed to convert: " + number);
-                    return Duration();
-                }
-                number.clear();
+                value = &days;
                 break;
+            case 'T':
             case '+':
-                break;
+            case 'P':
+                continue;
             case '-':
                 negative = true;
-                break;
-            case 'P':
-                break;
+                continue;
             default:
-                ERROR("failed to convert duration: " + *it);
+                ERROR("failed to convert duration: " + d);
                 return Duration();
         }
+        if (!gotNumber || overflow) {
+            ERROR("failed to convert duration: " + d);
+            return Duration();
+        }
+        *value = number;
+        if (value == &weeks) {
+            return Duration(weeks, negative);
+        }
+        number = 0;
+        gotNumber = false;
     }
     return Duration(days, hours, minutes, seconds, negative);
 }
@@ -424,6 +376,9 @@ Kolab::Attachment toAttachment(T aProp)
     if (aProp.uri()) {
         a.setUri(*aProp.uri(), mimetype);
     } else if (aProp.binary()) {
+        if (Utils::exceedsAttachmentSize(aProp.binary()->size() / 4 * 3)) {
+            throw Utils::ResourceLimitExceeded();
+        }
         a.setData(base64_decode(*aProp.binary()), mimetype);
     } else {
         ERROR("no uri and no data available");
@@ -589,78 +544,42 @@ std::auto_ptr<I> fromDateTimeList(const std::vector<cDateTime> &dtlist)
 
 //=== Attendee ===
 
-std::string mapPartStat(PartStatus status)
+const char *mapPartStat(PartStatus status)
 {
-    switch (status) {
-        case PartAccepted:
-            return PARTACCEPTED;
-        case PartDeclined:
-            return PARTDECLINED;
-        case PartDelegated:
-            return PARTDELEGATED;
-        case PartNeedsAction:
-            return PARTNEEDSACTION;
-        case PartTentative:
-            return PARTTENTATIVE;
-        case PartInProcess:
-            return PARTINPROCESS;
-        case PartCompleted:
-            return PARTCOMPLETED;
-    }
-    ERROR("PartStat not handled: " + status);
-    return std::string();
+    const EnumString<PartStatus> *entry = findEnumString(partStatStrings, status);
+    if (!entry) {
+        ERROR("PartStat not handled: " + boost::lexical_cast<std::string>(status));
+        return "";
+    }
+    return entry->string;
 }
 
 PartStatus mapPartStat(const std::string &status)
 {
-    if (status == PARTACCEPTED) {
-        return PartAccepted;
-    } else if (status == PARTDECLINED) {
-        return PartDeclined;
-    } else if (status == PARTDELEGATED) {
-        return PartDelegated;
-    } else if (status == PARTNEEDSACTION) {
-        return PartNeedsAction;
-    } else if (status == PARTTENTATIVE) {
-        return PartTentative;
-    } else if (status == PARTINPROCESS) {
-        return PartInProcess;
-    } else if (status == PARTCOMPLETED) {
-        return PartCompleted;
-    }
-    ERROR("PartStat not handled: " + status);
-    return PartNeedsAction;
+    PartStatus partStat = PartNeedsAction;
+    if (!enumFromString(partStatStrings, status, partStat)) {
+        ERROR("PartStat not handled: " + status);
+    }
+    return partStat;
 }
 
-std::string mapRole(Role status)
+const char *mapRole(Role status)
 {
-    switch (status) {
-        case Chair:
-            return std::string(CHAIR);
-        case NonParticipant:
-            return NONPARTICIPANT;
-        case Optional:
-            return OPTIONAL;
-        case Required:
-            return REQUIRED;
-    }
-    ERROR("PartStat not handled: " + status);
-    return std::string();
+    const EnumString<Role> *entry = findEnumString(roleStrings, status);
+    if (!entry) {
+        ERROR("Role not handled: " + boost::lexical_cast<std::string>(status));
+        return "";
+    }
+    return entry->string;
 }
 
 Role mapRole(const std::string &status)
 {
-    if (status == CHAIR) {
-        return Chair;
-    } else if (status == NONPARTICIPANT) {
-        return NonParticipant;
-    } else if (status == OPTIONAL) {
-        return Optional;
-    } else if (status == REQUIRED) {
-        return Required;
-    }
-    ERROR("Unhandled Role " + status);
-    return Required;
+    Role role = Required;
+    if (!enumFromString(roleStrings, status, role)) {
+        ERROR("Unhandled Role " + status);
+    }
+    return role;
 }
 
 
@@ -759,6 +678,7 @@ Role mapRole(const std::string &status)
     static void setByday(RecurrencePtr &r, const icalendar_2_0::RecurType::byday_sequence &list)
     {
         std::vector<DayPos> by;
+        by.reserve(list.size());
         for (icalendar_2_0::RecurType::byday_const_iterator it(list.begin()); it != list.end(); it++) {
             by.push_back(toDayPos(*it));
         }
@@ -769,7 +689,8 @@ Role mapRole(const std::string &status)
     std::vector<int> bylist(const xsd::cxx::tree::sequence <T> &list)
     { 
         std::vector<int> by;
-        BOOST_FOREACH(const T i, list) {
+        by.reserve(list.size());
+        BOOST_FOREACH(const T &i, list) {
             by.push_back(convertToInt<I>(i));
         }
         return by;
@@ -825,13 +746,8 @@ void setIncidenceProperties(I &inc, const T &prop)
     }
     
     if (prop.class_()) {
-        std::string string(toString(*prop.class_()));
         Kolab::Classification sec = ClassPublic;
-        if (string == PRIVATE) {
-            sec = ClassPrivate;
-        } else if (string == CONFIDENTIAL) {
-            sec = ClassConfidential;
-        }
+        enumFromString(classificationStrings, (*prop.class_()).text(), sec);
         inc.setClassification(sec);
     }
     
@@ -857,23 +773,9 @@ void setIncidenceProperties(I &inc, const T &prop)
     }
 
     if (prop.status()) {
-        const std::string &status =  toString(*prop.status());
-        if (status == NEEDSACTION) {
-            inc.setStatus(StatusNeedsAction);
-        } else if (status == COMPLETED || status == COMPLETED_COMPAT) {
-            inc.setStatus(StatusCompleted);
-        } else if (status == INPROCESS) {
-            inc.setStatus(StatusInProcess);
-        } else if (status == CANCELLED) {
-            inc.setStatus(StatusCancelled);
-        } else if (status == TENTATIVE) {
-            inc.setStatus(StatusTentative);
-        } else if (status == CONFIRMED) {
-            inc.setStatus(StatusConfirmed);
-        } else if (status == DRAFT) {
-            inc.setStatus(StatusDraft);
-        } else if (status == FINAL) {
-            inc.setStatus(StatusFinal);
+        Kolab::Status status;
+        if (enumFromString(statusStrings, (*prop.status()).text(), status)) {
+            inc.setStatus(status);
         } else {
             ERROR("Unhandled status");
         }
@@ -881,7 +783,8 @@ void setIncidenceProperties(I &inc, const T &prop)
     
     if (prop.attendee().size()) {
         std::vector<Kolab::Attendee> attendees;
-        BOOST_FOREACH(typename T::attendee_type aProp, prop.attendee()) {
+        attendees.reserve(prop.attendee().size());
+        BOOST_FOREACH(const typename T::attendee_type &aProp, prop.attendee()) {
             Kolab::Attendee a;
             std::string name;
             if (aProp.parameters()) {
@@ -920,16 +823,9 @@ void setIncidenceProperties(I &inc, const T &prop)
                         a.setDelegatedFrom(list);
                     }
                     if (const icalendar_2_0::CutypeParamType * p = dynamic_cast<const icalendar_2_0::CutypeParamType*> (&*it)) {
-                        if (p->text() == RESOURCE) {
-                            a.setCutype(CutypeResource);
-                        } else if (p->text() == INDIVIDUAL) {
-                            a.setCutype(CutypeIndividual);
-                        } else if (p->text() == GROUP) {
-                            a.setCutype(CutypeGroup);
-                        } else if (p->text() == ROOM) {
-                            a.setCutype(CutypeGroup);
-                        } else if (p->text() == UNKNOWN) {
-                            a.setCutype(CutypeGroup);
+                        Kolab::Cutype cutype;
+                        if (enumFromString(cutypeStrings, p->text(), cutype)) {
+                            a.setCutype(cutype);
                         } else {
                             WARNING("Invalid attendee cutype");
                         }
@@ -946,7 +842,8 @@ void setIncidenceProperties(I &inc, const T &prop)
     
     if (prop.attach().size()) {
         std::vector<Kolab::Attachment> attachments;
-        BOOST_FOREACH(typename T::attach_type aProp, prop.attach()) {
+        attachments.reserve(prop.attach().size());
+        BOOST_FOREACH(const typename T::attach_type &aProp, prop.attach()) {
             const Kolab::Attachment &a = toAttachment<typename T::attach_type>(aProp);
             if (!a.isValid()) {
                 ERROR("invalid attachment");
@@ -959,7 +856,8 @@ void setIncidenceProperties(I &inc, const T &prop)
     
     if (prop.x_custom().size()) {
         std::vector<Kolab::CustomProperty> customProperties;
-        BOOST_FOREACH(typename T::x_custom_type p, prop.x_custom()) {
+        customProperties.reserve(prop.x_custom().size());
+        BOOST_FOREACH(const typename T::x_custom_type &p, prop.x_custom()) {
             customProperties.push_back(CustomProperty(p.identifier(), p.value()));
         }
         inc.setCustomProperties(customProperties);
@@ -1067,7 +965,7 @@ std::auto_ptr< icalendar_2_0::RrulePropType > recurrenceProperty(const Recurrenc
     if (!r.byday().empty()) {
         RecurType::byday_sequence byday;
         const std::vector<Kolab::DayPos> &l = r.byday(); 
-        BOOST_FOREACH(Kolab::DayPos daypos, l) {
+        BOOST_FOREACH(const Kolab::DayPos &daypos, l) {
             byday.push_back(fromDayPos(daypos));
         }
         recur.byday(byday);
@@ -1104,17 +1002,8 @@ void getIncidenceProperties(T &prop, const I &inc)
     
     prop.sequence(fromInt<xml_schema::integer>(inc.sequence()));
     
-    switch (inc.classification()) {
-        case Kolab::ClassConfidential:
-            prop.class_(typename properties::class_type(CONFIDENTIAL));
-            break;
-        case Kolab::ClassPrivate:
-            prop.class_(typename properties::class_type(PRIVATE));
-            break;
-        default:
-            prop.class_(typename properties::class_type(PUBLIC));
-            break;
-    }
+    const EnumString<Kolab::Classification> *classification = findEnumString(classificationStrings, inc.classification());
+    prop.class_(typename properties::class_type(classification ? classification->string : classificationStrings[0].string));
     
     if (!inc.categories().empty()) {
         prop.categories(*fromStringList<typename properties::categories_type>(inc.categories()));
@@ -1137,33 +1026,11 @@ void getIncidenceProperties(T &prop, const I &inc)
     }
 
     if (inc.status() != StatusUndefined) {
-        switch (inc.status()) {
-            case StatusNeedsAction:
-                prop.status(typename properties::status_type(NEEDSACTION));
-                break;
-            case StatusCompleted:
-                prop.status(typename properties::status_type(COMPLETED));
-                break;
-            case StatusInProcess:
-                prop.status(typename properties::status_type(INPROCESS));
-                break;
-            case StatusCancelled:
-                prop.status(typename properties::status_type(CANCELLED));
-                break;
-            case StatusTentative:
-                prop.status(typename properties::status_type(TENTATIVE));
-                break;
-            case StatusConfirmed:
-                prop.status(typename properties::status_type(CONFIRMED));
-                break;
-            case StatusDraft:
-                prop.status(typename properties::status_type(DRAFT));
-                break;
-            case StatusFinal:
-                prop.status(typename properties::status_type(FINAL));
-                break;
-            default:
-                ERROR("unhandled status " + inc.status());
+        const EnumString<Kolab::Status> *status = findEnumString(statusStrings, inc.status());
+        if (status) {
+            prop.status(typename properties::status_type(status->string));
+        } else {
+            ERROR("unhandled status " + boost::lexical_cast<std::string>(inc.status()));
         }
 
     }
@@ -1177,13 +1044,13 @@ void getIncidenceProperties(T &prop, const I &inc)
             
             typename properties::attendee_type::parameters_type &p = *attendee.parameters();
             
-            std::string stat = mapPartStat(a.partStat());
-            if (!stat.empty()) {
+            const char *stat = mapPartStat(a.partStat());
+            if (*stat) {
                 p.baseParameter().push_back(icalendar_2_0::PartstatParamType(stat));
             }
             
-            std::string r = mapRole(a.role());
-            if (!r.empty()) {
+            const char *r = mapRole(a.role());
+            if (*r) {
                 p.baseParameter().push_back(icalendar_2_0::RoleParamType(r));
             }
             
@@ -1208,26 +1075,12 @@ void getIncidenceProperties(T &prop, const I &inc)
             }
 
             if (a.cutype() != CutypeIndividual) {
-                std::string type;
-                switch (a.cutype()) {
-                    case CutypeGroup:
-                        type = GROUP;
-                        break;
-                    case CutypeResource:
-                        type = RESOURCE;
-                        break;
-                    case CutypeRoom:
-                        type = ROOM;
-                        break;
-                    case CutypeUnknown:
-                        type = UNKNOWN;
-                        break;
-                    default:
-                        WARNING("unknown cutype");
-                        type = INDIVIDUAL;
-                        break;
+                const EnumString<Kolab::Cutype> *cutype = findEnumString(cutypeStrings, a.cutype());
+                if (!cutype) {
+                    WARNING("unknown cutype");
+                    cutype = findEnumString(cutypeStrings, CutypeIndividual);
                 }
-                p.baseParameter().push_back(icalendar_2_0::CutypeParamType(type));
+                p.baseParameter().push_back(icalendar_2_0::CutypeParamType(cutype->string));
             }
 
             prop.attendee().push_back(attendee);
@@ -1537,15 +1390,11 @@ template < > struct IncidenceTrait <Kolab::Event>
         return components.vevent().end();
     }
 
-    static IncidencePtr resolveExceptions(const std::vector<IncidencePtr> &list)
+    static void resolveExceptions(IncidenceType &incidence, const std::vector<IncidenceType> &exceptions)
     {
-        IncidencePtr incidence = *list.begin();
-        std::vector<IncidenceType> exceptions;
-        for (std::vector < IncidencePtr >::const_iterator it = list.begin()+1; it != list.end(); it++) {
-            exceptions.push_back(**it);
+        if (!exceptions.empty()) {
+            incidence.setExceptions(exceptions);
         }
-        incidence->setExceptions(exceptions);
-        return incidence;
     }
     
     static void addExceptions(icalendar_2_0::VcalendarType::components_type &components, const Kolab::Event &event, KolabType::properties_type props)
@@ -1632,15 +1481,11 @@ template < > struct IncidenceTrait <Kolab::Todo>
         return components.vtodo().end();
     }
     
-    static IncidencePtr resolveExceptions(const std::vector<IncidencePtr> &list)
+    static void resolveExceptions(IncidenceType &incidence, const std::vector<IncidenceType> &exceptions)
     {
-        IncidencePtr incidence = *list.begin();
-        std::vector<IncidenceType> exceptions;
-        for (std::vector < IncidencePtr >::const_iterator it = list.begin()+1; it != list.end(); it++) {
-            exceptions.push_back(**it);
+        if (!exceptions.empty()) {
+            incidence.setExceptions(exceptions);
         }
-        incidence->setExceptions(exceptions);
-        return incidence;
     }
     
     static void addExceptions(icalendar_2_0::VcalendarType::components_type &components, const Kolab::Todo &event, KolabType::properties_type props)
@@ -1687,9 +1532,8 @@ template < > struct IncidenceTrait <Kolab::Journal>
         return components.vjournal().end();
     }
     
-    static IncidencePtr resolveExceptions(const std::vector<IncidencePtr> &list)
+    static void resolveExceptions(IncidenceType &, const std::vector<IncidenceType> &)
     {
-        return *list.begin();
     }
     
     static void addExceptions(icalendar_2_0::VcalendarType::components_type &, const Kolab::Journal &, KolabType::properties_type)
@@ -1725,23 +1569,12 @@ template < > struct IncidenceTrait <Kolab::Freebusy>
                 icalendar_2_0::KolabFreebusy::properties_type::freebusy_type fb;
                 
                 icalendar_2_0::BasePropertyType::parameters_type params;
-                std::string fbtype;
-                switch (fbPeriod.type()) {
-                    case FreebusyPeriod::Busy:
-                        fbtype = BUSY;
-                        break;
-                    case FreebusyPeriod::Tentative:
-                        fbtype = BUSY_TENTATIVE;
-                        break;
-                    case FreebusyPeriod::OutOfOffice:
-                        fbtype = BUSY_OUTOFOFFICE;
-                        break;
-                    case FreebusyPeriod::Invalid:
-                    default:
-                        WARNING("Invalid fb type");
-                        continue;
+                const EnumString<FreebusyPeriod::FBType> *fbtype = findEnumString(fbtypeStrings, fbPeriod.type());
+                if (!fbtype) {
+                    WARNING("Invalid fb type");
+                    continue;
                 }
-                params.baseParameter().push_back(icalendar_2_0::FbtypeParamType(fbtype));
+                params.baseParameter().push_back(icalendar_2_0::FbtypeParamType(fbtype->string));
                 if (!fbPeriod.eventUid().empty() || fbPeriod.eventSummary().empty() || fbPeriod.eventLocation().empty()) {
                     params.baseParameter().push_back(icalendar_2_0::XFBevent(fbPeriod.eventUid(), fbPeriod.eventSummary(), fbPeriod.eventLocation()));
                 }
@@ -1789,21 +1622,21 @@ template < > struct IncidenceTrait <Kolab::Freebusy>
         }
         if (!prop.freebusy().empty()) {
             std::vector<Kolab::FreebusyPeriod> fbperiods;
+            fbperiods.reserve(prop.freebusy().size());
 
-
-            BOOST_FOREACH(icalendar_2_0::FreebusyPropType aProp, prop.freebusy()) {
+            BOOST_FOREACH(const icalendar_2_0::FreebusyPropType &aProp, prop.freebusy()) {
+                if (Utils::exceedsTime()) {
+                    throw Utils::ResourceLimitExceeded();
+                }
                 Kolab::FreebusyPeriod fbPeriod;
                 fbPeriod.setType(Kolab::FreebusyPeriod::Busy);
                 if (aProp.parameters()) {
                     const icalendar_2_0::FreebusyPropType::parameters_type &parameters = *aProp.parameters();
                     for (icalendar_2_0::FreebusyPropType::parameters_type::baseParameter_const_iterator it(parameters.baseParameter().begin()); it != parameters.baseParameter().end(); it++) {
                         if (const icalendar_2_0::FbtypeParamType * p = dynamic_cast<const icalendar_2_0::FbtypeParamType*> (&*it)) {
-                            if (p->text() == BUSY) {
-                                fbPeriod.setType(Kolab::FreebusyPeriod::Busy);
-                            } else if (p->text() == BUSY_OUTOFOFFICE) {
-                                fbPeriod.setType(Kolab::FreebusyPeriod::OutOfOffice);
-                            } else if (p->text() == BUSY_TENTATIVE) {
-                                fbPeriod.setType(Kolab::FreebusyPeriod::Tentative);
+                            Kolab::FreebusyPeriod::FBType fbtype;
+                            if (enumFromString(fbtypeStrings, p->text(), fbtype)) {
+                                fbPeriod.setType(fbtype);
                             } else {
                                 WARNING("Invalid fb type, default to busy");
                             }
@@ -1816,7 +1649,8 @@ template < > struct IncidenceTrait <Kolab::Freebusy>
                 }
 
                 std::vector <Kolab::Period > periods;
-                BOOST_FOREACH(icalendar_2_0::FreebusyPropType::period_type period, aProp.period()) {
+                periods.reserve(aProp.period().size());
+                BOOST_FOREACH(const icalendar_2_0::FreebusyPropType::period_type &period, aProp.period()) {
                     if (!period.end()) {
                         WARNING("Period end date is required and duration is not supported, skipping period");
                         continue;
@@ -1844,9 +1678,8 @@ template < > struct IncidenceTrait <Kolab::Freebusy>
         return components.vfreebusy().end();
     }
     
-    static IncidencePtr resolveExceptions(const std::vector<IncidencePtr> &list)
+    static void resolveExceptions(IncidenceType &, const std::vector<IncidenceType> &)
     {
-        return *list.begin();
     }
     
     static void addExceptions(icalendar_2_0::VcalendarType::components_type &, const Kolab::Freebusy &, KolabType::properties_type)
@@ -1866,21 +1699,23 @@ std::string serializeIncidence(const typename T::IncidenceType &incidence, const
     typedef typename T::KolabType KolabType;
 
     try {
+        Utils::PhaseTimer convertTimer(ConvertPhase);
 
         typename KolabType::properties_type::uid_type uid( getUID(incidence.uid()));
         setCreatedUid(uid.text());
+        const cDateTime now = (incidence.lastModified().isValid() && incidence.created().isValid()) ? cDateTime() : timestamp();
         typename KolabType::properties_type::dtstamp_type dtstamp;
         if (incidence.lastModified().isValid()) {
             dtstamp.date_time(fromDateTime(incidence.lastModified()));
         } else {
-            dtstamp.date_time(fromDateTime(timestamp()));
+            dtstamp.date_time(fromDateTime(now));
         }
 
         typename KolabType::properties_type::created_type created;
         if (incidence.created().isValid()) {
             created.date_time(fromDateTime(incidence.created()));
         } else {
-            created.date_time(fromDateTime(timestamp()));
+            created.date_time(fromDateTime(now));
         }
         typename KolabType::properties_type eventProps(uid, created, dtstamp);
         
@@ -1906,8 +1741,13 @@ std::string serializeIncidence(const typename T::IncidenceType &incidence, const
         xml_schema::namespace_infomap map;
         map[""].name = XCAL_NAMESPACE;
         
+        convertTimer.stop();
+        Utils::PhaseTimer serializeTimer(SerializePhase);
         std::ostringstream ostringstream;
-        icalendar_2_0::icalendar(ostringstream, icalendar, map);
+        XMLParserWrapper::ensureInitialized();
+        xml_schema::dom::auto_ptr<xercesc::DOMDocument> document(XMLParserWrapper::createDocument("icalendar", XCAL_NAMESPACE, map));
+        icalendar_2_0::icalendar(*document, icalendar, xml_schema::flags::dont_initialize);
+        XMLParserWrapper::writeDocument(ostringstream, *document);
         return ostringstream.str();
     } catch  (const xml_schema::exception& e) {
         CRITICAL("failed to write Incidence");
@@ -1929,13 +1769,15 @@ typename T::IncidencePtr deserializeIncidence(const std::string& s, bool isUrl)
     try {
         std::auto_ptr<icalendar_2_0::IcalendarType> icalendar;
         if (isUrl) {
-            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::inst().parseFile(s);
+            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::Lease()->parseFile(s);
             if (doc.get()) {
+                Utils::PhaseTimer timer(BindPhase);
                 icalendar = icalendar_2_0::icalendar(doc);
             }
         } else {
-            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::inst().parseString(s);
+            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::Lease()->parseString(s);
             if (doc.get()) {
+                Utils::PhaseTimer timer(BindPhase);
                 icalendar = icalendar_2_0::icalendar(doc);
             }
         }
@@ -1945,27 +1787,51 @@ typename T::IncidencePtr deserializeIncidence(const std::string& s, bool isUrl)
             return IncidencePtr();
         }
 
+        Utils::PhaseTimer convertTimer(ConvertPhase);
+
         const icalendar_2_0::VcalendarType &vcalendar = icalendar->vcalendar();
 
-        std::vector < IncidencePtr > incidences;
+        const std::size_t count = static_cast<std::size_t>(std::distance(T::begin(vcalendar.components()), T::end(vcalendar.components())));
+        if (count > 1 && Utils::exceedsExceptionCount(count - 1)) {
+            throw Utils::ResourceLimitExceeded();
+        }
+        //Exceptions typically repeat the attendees of the main event
+        MailtoCacheScope mailtoCache(count > 1);
+        //The first component is the incidence itself, the rest are its exceptions, which are read in place
+        IncidencePtr incidence;
+        std::vector < IncidenceType > exceptions;
+        if (count > 1) {
+            exceptions.reserve(count - 1);
+        }
         for (typename xsd::cxx::tree::sequence< KolabType >::const_iterator it(T::begin(vcalendar.components())); it != T::end(vcalendar.components()); it++) {
-            IncidencePtr e = IncidencePtr(new IncidenceType);
+            if (Utils::exceedsTime()) {
+                throw Utils::ResourceLimitExceeded();
+            }
             const KolabType &event = *it;
-            T::readIncidence(*e, event);
-            incidences.push_back(e);
+            if (!incidence) {
+                incidence = IncidencePtr(new IncidenceType);
+                T::readIncidence(*incidence, event);
+            } else {
+                exceptions.push_back(IncidenceType());
+                T::readIncidence(exceptions.back(), event);
+            }
         }
         
         setProductId( vcalendar.properties().prodid().text() );
         setXCalVersion(vcalendar.properties().version().text());
         setKolabVersion( vcalendar.properties().x_kolab_version().text() );
 
-        if (incidences.empty()) {
+        if (!incidence) {
             CRITICAL("no incidence in object");
             return IncidencePtr();
         }
-        return T::resolveExceptions(incidences);
+        T::resolveExceptions(*incidence, exceptions);
+        return incidence;
     } catch  (const xml_schema::exception& e) {
-        std::cerr <<  e << std::endl;
+        XMLParserWrapper::reportException(e, Kolab::ParseError);
+    } catch (const Utils::ResourceLimitExceeded &) {
+        //Already reported
+        return IncidencePtr();
     } catch (...) {
         CRITICAL("Unhandled exception");
     }
@@ -1980,6 +1846,7 @@ std::string serializeFreebusy(const Kolab::Freebusy &incidence, const std::strin
     typedef typename T::KolabType KolabType;
 
     try {
+        Utils::PhaseTimer convertTimer(ConvertPhase);
 
         typename KolabType::properties_type::uid_type uid( getUID(incidence.uid()));
         setCreatedUid(uid.text());
@@ -2007,11 +1874,16 @@ std::string serializeFreebusy(const Kolab::Freebusy &incidence, const std::strin
         xml_schema::namespace_infomap map;
         map[""].name = XCAL_NAMESPACE;
 
+        convertTimer.stop();
+        Utils::PhaseTimer serializeTimer(SerializePhase);
         std::ostringstream ostringstream;
-        icalendar_2_0::icalendar(ostringstream, icalendar, map);
+        XMLParserWrapper::ensureInitialized();
+        xml_schema::dom::auto_ptr<xercesc::DOMDocument> document(XMLParserWrapper::createDocument("icalendar", XCAL_NAMESPACE, map));
+        icalendar_2_0::icalendar(*document, icalendar, xml_schema::flags::dont_initialize);
+        XMLParserWrapper::writeDocument(ostringstream, *document);
         return ostringstream.str();
     } catch  (const xml_schema::exception& e) {
-        std::cerr <<  e << std::endl;
+        XMLParserWrapper::reportException(e, Kolab::SerializationError);
     } catch (...) {
         CRITICAL("Unhandled exception");
     }
@@ -42,6 +42,36 @@ namespace Kolab {
     const char* const MIME_PKCS7_MIME = "application/pkcs7-mime";
 
 using namespace Kolab::Utils;
+using Kolab::Shared::EnumString;
+using Kolab::Shared::flagsFromStrings;
+using Kolab::Shared::flagsToStrings;
+
+//The type parameter values (in serialization order)
+const EnumString<int> relatedTypeStrings[] = {
+    ENUM_STRING(Kolab::Related::Child, "child"),
+    ENUM_STRING(Kolab::Related::Spouse, "spouse"),
+    ENUM_STRING(Kolab::Related::Assistant, "x-assistant"),
+    ENUM_STRING(Kolab::Related::Manager, "x-manager")
+};
+
+//Used for addresses and email addresses as well, which share the values of Telephone::Home/Work
+const EnumString<int> homeWorkTypeStrings[] = {
+    ENUM_STRING(Kolab::Telephone::Home, "home"),
+    ENUM_STRING(Kolab::Telephone::Work, "work")
+};
+
+const EnumString<int> telephoneTypeStrings[] = {
+    ENUM_STRING(Kolab::Telephone::Car, "x-car"),
+    ENUM_STRING(Kolab::Telephone::Cell, "cell"),
+    ENUM_STRING(Kolab::Telephone::Fax, "fax"),
+    ENUM_STRING(Kolab::Telephone::Home, "home"),
+    ENUM_STRING(Kolab::Telephone::Work, "work"),
+    ENUM_STRING(Kolab::Telephone::Text, "text"),
+    ENUM_STRING(Kolab::Telephone::Voice, "voice"),
+    ENUM_STRING(Kolab::Telephone::Video, "video"),
+    ENUM_STRING(Kolab::Telephone::Textphone, "textphone"),
+    ENUM_STRING(Kolab::Telephone::Pager, "pager")
+};
     
 template <typename T> 
 std::string getType();
@@ -278,18 +308,7 @@ vcard_4_0::relatedPropType fromRelated(const Kolab::Related &r)
         vcard::adr_type::parameters_type b;
         
         vcard_4_0::typeParamType::text_sequence seq;
-        if (r.relationTypes() & Kolab::Related::Child) {
-            seq.push_back(TypeValueType::child);
-        }
-        if (r.relationTypes() & Kolab::Related::Spouse) {
-            seq.push_back(TypeValueType::spouse);
-        }
-        if (r.relationTypes() & Kolab::Related::Assistant) {
-            seq.push_back(TypeValueType::x_assistant);
-        }
-        if (r.relationTypes() & Kolab::Related::Manager) {
-            seq.push_back(TypeValueType::x_manager);
-        }
+        flagsToStrings(relatedTypeStrings, r.relationTypes(), seq);
         if (!seq.empty()) {
             vcard_4_0::typeParamType type;
             type.text(seq);
@@ -320,22 +339,7 @@ Kolab::Related toRelated(const vcard_4_0::relatedPropType &r)
     if (r.parameters()) {
         BOOST_FOREACH(const vcard_4_0::ArrayOfParameters::baseParameter_type &param, (*r.parameters()).baseParameter()) {
             if (const vcard_4_0::typeParamType *rel = dynamic_cast<const vcard_4_0::typeParamType*> (&param)) {
-                int types = 0;
-                BOOST_FOREACH(const std::string &s, rel->text()) {
-                    if (s == vcard_4_0::TypeValueType(vcard_4_0::TypeValueType::child)) {
-                        types |= Kolab::Related::Child;
-                    }
-                    if (s == vcard_4_0::TypeValueType(vcard_4_0::TypeValueType::spouse)) {
-                        types |= Kolab::Related::Spouse;
-                    }
-                    if (s == vcard_4_0::TypeValueType(vcard_4_0::TypeValueType::x_assistant)) {
-                        types |= Kolab::Related::Assistant;
-                    }
-                    if (s == vcard_4_0::TypeValueType(vcard_4_0::TypeValueType::x_manager)) {
-                        types |= Kolab::Related::Manager;
-                    }
-                }
-                related.setRelationTypes(types);
+                related.setRelationTypes(flagsFromStrings(relatedTypeStrings, rel->text()));
             } 
         }
     }
@@ -356,12 +360,7 @@ vcard_4_0::vcard::adr_type fromAddress(const Kolab::Address &address)
     vcard::adr_type::parameters_type b;
     if (address.types()) {
         vcard_4_0::typeParamType::text_sequence seq;
-        if (address.types() & Kolab::Address::Home) {
-            seq.push_back(TypeValueType::home);
-        }
-        if (address.types() & Kolab::Address::Work) {
-            seq.push_back(TypeValueType::work);
-        }
+        flagsToStrings(homeWorkTypeStrings, address.types(), seq);
         if (!seq.empty()) {
             vcard_4_0::typeParamType type;
             type.text(seq);
@@ -386,16 +385,7 @@ Kolab::Address toAddress(const vcard_4_0::vcard::adr_type &adr, bool *isPreferre
             } else if (isPreferred && dynamic_cast<const vcard_4_0::prefParamType*> (&param)) {
                 *isPreferred = true;
             } else if (const vcard_4_0::typeParamType *rel = dynamic_cast<const vcard_4_0::typeParamType*> (&param)) {
-                int types = 0;
-                BOOST_FOREACH(const std::string &s, rel->text()) {
-                    if (s == TypeValueType(TypeValueType::work)) {
-                        types |= Kolab::Telephone::Work;
-                    }
-                    if (s == TypeValueType(TypeValueType::home)) {
-                        types |= Kolab::Telephone::Home;
-                    }
-                }
-                address.setTypes(types);
+                address.setTypes(flagsFromStrings(homeWorkTypeStrings, rel->text()));
             } 
         }
     }
@@ -619,36 +609,7 @@ void writeCard<Kolab::Contact>(vcard_4_0::vcard &vcard, const Kolab::Contact &co
         BOOST_FOREACH(const Kolab::Telephone &t, l) {
             vcard::tel_type tel(t.number());
             vcard_4_0::typeParamType telTypeParam;
-            if (t.types() & Kolab::Telephone::Car) {
-                telTypeParam.text().push_back(TypeValueType::x_car);
-            } 
-            if (t.types() & Kolab::Telephone::Cell) {
-                telTypeParam.text().push_back(TypeValueType::cell);
-            } 
-            if (t.types() & Kolab::Telephone::Fax) {
-                telTypeParam.text().push_back(TypeValueType::fax);
-            } 
-            if (t.types() & Kolab::Telephone::Home) {
-                telTypeParam.text().push_back(TypeValueType::home);
-            } 
-            if (t.types() & Kolab::Telephone::Work) {
-                telTypeParam.text().push_back(TypeValueType::work);
-            } 
-            if (t.types() & Kolab::Telephone::Text) {
-                telTypeParam.text().push_back(TypeValueType::text);
-            } 
-            if (t.types() & Kolab::Telephone::Voice) {
-                telTypeParam.text().push_back(TypeValueType::voice);
-            } 
-            if (t.types() & Kolab::Telephone::Video) {
-                telTypeParam.text().push_back(TypeValueType::video);
-            } 
-            if (t.types() & Kolab::Telephone::Textphone) {
-                telTypeParam.text().push_back(TypeValueType::textphone);
-            } 
-            if (t.types() & Kolab::Telephone::Pager) {
-                telTypeParam.text().push_back(TypeValueType::pager);
-            }
+            flagsToStrings(telephoneTypeStrings, t.types(), telTypeParam.text());
             vcard::tel_type::parameters_type params;
             if(contact.telephonesPreferredIndex() == index) {
                 params.baseParameter().push_back(vcard_4_0::prefParamType(vcard_4_0::prefParamType::integer_default_value()));
@@ -675,12 +636,7 @@ void writeCard<Kolab::Contact>(vcard_4_0::vcard &vcard, const Kolab::Contact &co
         BOOST_FOREACH(const Kolab::Email &e, l) {
             vcard::email_type email(e.address());
             vcard_4_0::typeParamType emailTypeParam;
-            if (e.types() & Kolab::Email::Home) {
-                emailTypeParam.text().push_back(TypeValueType::home);
-            } 
-            if (e.types() & Kolab::Email::Work) {
-                emailTypeParam.text().push_back(TypeValueType::work);
-            } 
+            flagsToStrings(homeWorkTypeStrings, e.types(), emailTypeParam.text());
             vcard::tel_type::parameters_type params;
             if (!emailTypeParam.text().empty()) {
                 params.baseParameter().push_back(emailTypeParam);
@@ -787,6 +743,7 @@ std::string serializeCard(const T &card, const std::string prod = std::string())
     clearErrors();
 
     try {
+        Utils::PhaseTimer convertTimer(ConvertPhase);
         vcard_4_0::vcard::uid_type uid(Shared::toURN(getUID(card.uid())));
         setCreatedUid(Shared::fromURN(uid.uri()));
         vcard_4_0::vcard::x_kolab_version_type kolab_version(KOLAB_FORMAT_VERSION);
@@ -811,11 +768,16 @@ std::string serializeCard(const T &card, const std::string prod = std::string())
         xml_schema::namespace_infomap map;
         map[""].name = XCARD_NAMESPACE;
         
+        convertTimer.stop();
+        Utils::PhaseTimer serializeTimer(SerializePhase);
         std::ostringstream ostringstream;
-        vcard_4_0::vcards(ostringstream, vcards, map);
+        XMLParserWrapper::ensureInitialized();
+        xml_schema::dom::auto_ptr<xercesc::DOMDocument> document(XMLParserWrapper::createDocument("vcards", XCARD_NAMESPACE, map));
+        vcard_4_0::vcards(*document, vcards, xml_schema::flags::dont_initialize);
+        XMLParserWrapper::writeDocument(ostringstream, *document);
         return ostringstream.str();
     } catch  (const xml_schema::exception& e) {
-        std::cerr <<  e << std::endl;
+        XMLParserWrapper::reportException(e, Kolab::SerializationError);
     } catch (...) {
         CRITICAL("Unhandled exception");
     }
@@ -868,11 +830,6 @@ boost::shared_ptr<Kolab::Contact> readCard <Kolab::Contact> (const vcard_4_0::Vc
             } else {
                 WARNING("No org present");
             }
-            std::string mimetype;
-            if (group.logo()) {
-                const std::string &logo = uriInlineDecoding((*group.logo()).uri(), mimetype);
-                aff.setLogo(logo, mimetype);
-            }
             aff.setRoles(toTextList<vcard::group_type::role_type>(group.role()));
             std::vector<Related> relateds;
             BOOST_FOREACH(const vcard::group_type::related_type &rel, group.related()) {
@@ -887,6 +844,16 @@ boost::shared_ptr<Kolab::Contact> readCard <Kolab::Contact> (const vcard_4_0::Vc
             list.push_back(aff);
         }
         contact->setAffiliations(list);
+        //Logos are only decoded on access
+        std::size_t index = 0;
+        std::string logo;
+        std::string mimetype;
+        BOOST_FOREACH (const vcard::group_type &group, vcard.group()) {
+            if (group.logo() && uriInlineSplit((*group.logo()).uri(), logo, mimetype)) {
+                contact->setEncodedAffiliationLogo(index, logo, mimetype);
+            }
+            index++;
+        }
     }
     if (!vcard.url().empty()) {
         std::vector<Kolab::Url> urls;
@@ -932,8 +899,15 @@ boost::shared_ptr<Kolab::Contact> readCard <Kolab::Contact> (const vcard_4_0::Vc
     }
     if (vcard.photo()) {
         std::string mimetype;
-        const std::string decodedPhoto =  uriInlineDecoding((*vcard.photo()).uri(), mimetype);
-        contact->setPhoto(decodedPhoto, mimetype);
+        std::string photo;
+        if (Utils::exceedsAttachmentSize((*vcard.photo()).uri().size() / 4 * 3)) {
+            throw Utils::ResourceLimitExceeded();
+        }
+        if (uriInlineSplit((*vcard.photo()).uri(), photo, mimetype)) {
+            contact->setEncodedPhoto(photo, mimetype);
+        } else {
+            contact->setPhoto(std::string(), mimetype);
+        }
     }
     if (vcard.gender()) {
         if ((*vcard.gender()).sex() == vcard::gender_type::sex_type::empty) {
@@ -946,7 +920,7 @@ boost::shared_ptr<Kolab::Contact> readCard <Kolab::Contact> (const vcard_4_0::Vc
     }
     if (!vcard.lang().empty()) {
         std::vector<std::string> list;
-        BOOST_FOREACH(const vcard::lang_type l, vcard.lang()) {
+        BOOST_FOREACH(const vcard::lang_type &l, vcard.lang()) {
             list.push_back(l.language_tag());
         }
         contact->setLanguages(list);
@@ -962,40 +936,7 @@ boost::shared_ptr<Kolab::Contact> readCard <Kolab::Contact> (const vcard_4_0::Vc
                     if (dynamic_cast<const vcard_4_0::prefParamType*> (&param)) {
                         preferredIndex = index;
                     } else if (const vcard_4_0::typeParamType *rel = dynamic_cast<const vcard_4_0::typeParamType*> (&param)) {
-                        int types = 0;
-                        BOOST_FOREACH(const std::string &s, rel->text()) {
-                            if (s == TypeValueType(TypeValueType::work)) {
-                                types |= Kolab::Telephone::Work;
-                            }
-                            if (s == TypeValueType(TypeValueType::home)) {
-                                types |= Kolab::Telephone::Home;
-                            }
-                            if (s == TypeValueType(TypeValueType::text)) {
-                                types |= Kolab::Telephone::Text;
-                            }
-                            if (s == TypeValueType(TypeValueType::voice)) {
-                                types |= Kolab::Telephone::Voice;
-                            }
-                            if (s == TypeValueType(TypeValueType::fax)) {
-                                types |= Kolab::Telephone::Fax;
-                            }
-                            if (s == TypeValueType(TypeValueType::cell)) {
-                                types |= Kolab::Telephone::Cell;
-                            }
-                            if (s == TypeValueType(TypeValueType::video)) {
-                                types |= Kolab::Telephone::Video;
-                            }
-                            if (s == TypeValueType(TypeValueType::pager)) {
-                                types |= Kolab::Telephone::Pager;
-                            }
-                            if (s == TypeValueType(TypeValueType::textphone)) {
-                                types |= Kolab::Telephone::Textphone;
-                            }
-                            if (s == TypeValueType(TypeValueType::x_car)) {
-                                types |= Kolab::Telephone::Car;
-                            }
-                        }
-                        telephone.setTypes(types);
+                        telephone.setTypes(flagsFromStrings(telephoneTypeStrings, rel->text()));
                     } 
                 }
             }
@@ -1038,16 +979,7 @@ boost::shared_ptr<Kolab::Contact> readCard <Kolab::Contact> (const vcard_4_0::Vc
                     if (dynamic_cast<const vcard_4_0::prefParamType*> (&param)) {
                         preferredIndex = i;
                     } else if (const vcard_4_0::typeParamType *rel = dynamic_cast<const vcard_4_0::typeParamType*> (&param)) {
-                        int types = 0;
-                        BOOST_FOREACH(const std::string &s, rel->text()) {
-                            if (s == TypeValueType(TypeValueType::work)) {
-                                types |= Kolab::Email::Work;
-                            }
-                            if (s == TypeValueType(TypeValueType::home)) {
-                                types |= Kolab::Email::Home;
-                            }
-                        }
-                        email.setTypes(types);
+                        email.setTypes(flagsFromStrings(homeWorkTypeStrings, rel->text()));
                     }
                 }
             }
@@ -1100,19 +1032,21 @@ boost::shared_ptr<Kolab::Contact> readCard <Kolab::Contact> (const vcard_4_0::Vc
     }
     
     if (!vcard.key().empty()) {
-        std::string mimetype;
-        std::vector<Kolab::Key> keys;
-        BOOST_FOREACH(const vcard_4_0::keyPropType &k, vcard.key()) {                
-            const std::string &key = uriInlineDecoding(k.uri(), mimetype);
-            if (mimetype == MIME_PGP_KEYS) {
-                keys.push_back(Kolab::Key(key, Kolab::Key::PGP));
-            } else if (mimetype == MIME_PKCS7_MIME) {
-                keys.push_back(Kolab::Key(key, Kolab::Key::PKCS7_MIME));
+        //Keys are only decoded on access
+        BOOST_FOREACH(const vcard_4_0::keyPropType &k, vcard.key()) {
+            const std::string &uri = k.uri();
+            InlineDataUri parts;
+            if (!parseInlineDataUri(uri, parts)) {
+                continue;
+            }
+            if (inlineMimetypeEquals(uri, parts, MIME_PGP_KEYS)) {
+                contact->addEncodedKey(uri.substr(parts.dataBegin), Kolab::Key::PGP);
+            } else if (inlineMimetypeEquals(uri, parts, MIME_PKCS7_MIME)) {
+                contact->addEncodedKey(uri.substr(parts.dataBegin), Kolab::Key::PKCS7_MIME);
             } else {
                 WARNING("wrong mimetype on key");
             }
         }
-        contact->setKeys(keys);
     }
     
     return contact;
@@ -1126,7 +1060,7 @@ boost::shared_ptr<Kolab::DistList> readCard <Kolab::DistList> (const vcard_4_0::
 
     if (!vcard.member().empty()) {
         std::vector<Kolab::ContactReference> members;
-
+        members.reserve(vcard.member().size());
         BOOST_FOREACH(const vcard_4_0::vcard::member_type & m, vcard.member()) {
             members.push_back(Shared::toContactReference(m.uri()));
         }
@@ -1142,13 +1076,15 @@ boost::shared_ptr<T> deserializeCard(const std::string& s, bool isUrl)
     try {
         std::auto_ptr<vcard_4_0::VcardsType> vcards;
         if (isUrl) {
-            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::inst().parseFile(s);
+            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::Lease()->parseFile(s);
             if (doc.get()) {
+                Utils::PhaseTimer timer(BindPhase);
                 vcards = vcard_4_0::vcards(doc);
             }
         } else {
-            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::inst().parseString(s);
+            xsd::cxx::xml::dom::auto_ptr <xercesc::DOMDocument > doc = XMLParserWrapper::Lease()->parseString(s);
             if (doc.get()) {
+                Utils::PhaseTimer timer(BindPhase);
                 vcards = vcard_4_0::vcards(doc);
             }
         }
@@ -1157,8 +1093,13 @@ boost::shared_ptr<T> deserializeCard(const std::string& s, bool isUrl)
             CRITICAL("failed to parse card!");
             return boost::shared_ptr<T>();
         }
+
+        Utils::PhaseTimer convertTimer(ConvertPhase);
         
         boost::shared_ptr<T> card = readCard<T>(vcards->vcard());
+        if (!card) {
+            return card;
+        }
         card->setUid(Shared::fromURN(vcards->vcard().uid().uri()));
         card->setName(vcards->vcard().fn().text());
         card->setLastModified(toDateTime(vcards->vcard().rev().timestamp()));
@@ -1178,7 +1119,10 @@ boost::shared_ptr<T> deserializeCard(const std::string& s, bool isUrl)
         
         return card;
     } catch  (const xml_schema::exception& e) {
-        std::cerr <<  e << std::endl;
+        XMLParserWrapper::reportException(e, Kolab::ParseError);
+    } catch (const Utils::ResourceLimitExceeded &) {
+        //Already reported
+        return boost::shared_ptr<T>();
     } catch (...) {
         CRITICAL("Unhandled exception");
     }
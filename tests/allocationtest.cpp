@@ -0,0 +1,241 @@
+/*
+    Copyright (C) 2012 Christian Mollekopf <mollekopf@kolabsys.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "allocationtest.h"
+
+#include <QtTest/QtTest>
+#include <src/kolabformat.h>
+#include <src/utils.h>
+#include "testobjects.h"
+#include <xercesc/util/XercesVersion.hpp>
+#include <xsd/cxx/version.hxx>
+#include <boost/version.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+
+/*
+ * All allocations of the process go through these, so everything (including our own containers and the xsd tree) is counted.
+ * Xerces allocates through the library's memory manager, which is accounted separately as well (see lastOperationMemory()).
+ */
+#if __cplusplus >= 201103L
+#define ALLOCATION_THROW
+#define DEALLOCATION_THROW noexcept
+#else
+#define ALLOCATION_THROW throw(std::bad_alloc)
+#define DEALLOCATION_THROW throw()
+#endif
+
+static unsigned long allocations = 0;
+
+static void *allocate(std::size_t size)
+{
+    Kolab::Utils::atomicAdd(allocations, 1);
+    void *p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new(std::size_t size) ALLOCATION_THROW { return allocate(size); }
+void *operator new[](std::size_t size) ALLOCATION_THROW { return allocate(size); }
+void operator delete(void *p) DEALLOCATION_THROW { std::free(p); }
+void operator delete[](void *p) DEALLOCATION_THROW { std::free(p); }
+#ifdef __cpp_sized_deallocation
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+#endif
+
+//Counts may vary slightly between runs of the same build, so a small increase is tolerated
+static const double tolerance = 0.05;
+
+static const char *baselineFile = TEST_DATA_PATH "/allocationbaseline.txt";
+//Regenerated baselines are written to the build directory, to be reviewed and copied over baselineFile
+static const char *updatedBaselineFile = TEST_BUILD_PATH "/allocationbaseline.txt";
+
+enum Operation {
+    Read,
+    Write
+};
+
+struct Counts {
+    Counts(): allocations(0), xercesAllocations(0) {}
+    unsigned long allocations;
+    unsigned long xercesAllocations;
+};
+
+/*
+ * The counts depend on the compiler (and its standard library), Xerces, xsd and boost,
+ * so the baseline only applies to the configuration it was recorded with.
+ */
+static std::string configuration()
+{
+    std::ostringstream key;
+#if defined(__clang__)
+    key << "clang-" << __clang_major__ << "." << __clang_minor__ << "." << __clang_patchlevel__;
+#elif defined(__GNUC__)
+    key << "gcc-" << __GNUC__ << "." << __GNUC_MINOR__ << "." << __GNUC_PATCHLEVEL__;
+#elif defined(_MSC_VER)
+    key << "msvc-" << _MSC_VER;
+#else
+    key << "unknown";
+#endif
+    key << "_xerces-" << XERCES_FULLVERSIONDOT << "_xsd-" << XSD_STR_VERSION << "_boost-" << BOOST_LIB_VERSION;
+    return key.str();
+}
+
+template <typename T>
+static Counts countAllocations(Operation operation, const T &object)
+{
+    const std::string serialized = write(object);
+    //The first operation loads the grammar and initializes caches, which is not what we're after
+    read(serialized, &object);
+    write(object);
+
+    const unsigned long before = Kolab::Utils::atomicAdd(allocations, 0);
+    if (operation == Read) {
+        read(serialized, &object);
+    } else {
+        write(object);
+    }
+    Counts counts;
+    counts.allocations = Kolab::Utils::atomicAdd(allocations, 0) - before;
+    counts.xercesAllocations = Kolab::lastOperationMemory().allocations;
+    qDebug() << "allocations:" << counts.allocations << "xerces allocations:" << counts.xercesAllocations;
+    return counts;
+}
+
+static Counts countAllocations(Operation operation, const std::string &type)
+{
+    if (type == "event") {
+        return countAllocations(operation, createEvent(0, false));
+    } else if (type == "recurringevent") {
+        return countAllocations(operation, createEvent(10, true));
+    } else if (type == "todo") {
+        return countAllocations(operation, createTodo());
+    } else if (type == "journal") {
+        return countAllocations(operation, createJournal());
+    } else if (type == "freebusy") {
+        return countAllocations(operation, createFreebusy(10));
+    } else if (type == "contact") {
+        return countAllocations(operation, createContact(1024));
+    } else if (type == "distlist") {
+        return countAllocations(operation, createDistlist(10));
+    } else if (type == "note") {
+        return countAllocations(operation, createNote());
+    } else if (type == "configuration") {
+        return countAllocations(operation, createConfiguration(10));
+    } else if (type == "file") {
+        return countAllocations(operation, createFile(1024));
+    }
+    return Counts();
+}
+
+void AllocationTest::initTestCase()
+{
+    Kolab::setMemoryAccountingEnabled(true);
+
+    //"version <configuration>" followed by lines of "[xerces_]<operation>_<type> <count>", '#' starts a comment
+    std::ifstream file(baselineFile);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream stream(line);
+        std::string name;
+        if (!(stream >> name)) {
+            continue;
+        }
+        if (name == "version") {
+            stream >> mBaselineConfiguration;
+            continue;
+        }
+        unsigned long count = 0;
+        if (stream >> count) {
+            mBaseline[name] = count;
+        }
+    }
+    //While regenerating, missing or exceeded rows are expected
+    mGated = !std::getenv("KOLAB_UPDATE_ALLOCATION_BASELINE") && mBaselineConfiguration == configuration();
+    if (!mGated) {
+        qDebug() << "No baseline recorded for" << QString::fromStdString(configuration()) << ", the counts are only printed";
+    }
+}
+
+void AllocationTest::checkBaseline(const std::string &name, unsigned long count)
+{
+    mMeasured[name] = count;
+    if (!mGated) {
+        return;
+    }
+    std::map<std::string, unsigned long>::const_iterator it = mBaseline.find(name);
+    QVERIFY2(it != mBaseline.end(), QString("No baseline for %1, regenerate it").arg(QString::fromStdString(name)).toLatin1().constData());
+    const unsigned long limit = static_cast<unsigned long>(static_cast<double>(it->second) * (1.0 + tolerance));
+    QVERIFY2(count <= limit, QString("%1: %2 allocations, the baseline is %3").arg(QString::fromStdString(name)).arg(count).arg(it->second).toLatin1().constData());
+}
+
+void AllocationTest::cleanupTestCase()
+{
+    if (!std::getenv("KOLAB_UPDATE_ALLOCATION_BASELINE")) {
+        return;
+    }
+    std::ofstream file(updatedBaselineFile);
+    file << "# Heap allocations of a single read or write, as counted by allocationtest.\n";
+    file << "# Regenerate with: KOLAB_UPDATE_ALLOCATION_BASELINE=1 tests/allocationtest, and copy the file from the build directory here.\n";
+    file << "# Only enforced for the configuration it was recorded with.\n";
+    file << "version " << configuration() << "\n";
+    for (std::map<std::string, unsigned long>::const_iterator it = mMeasured.begin(); it != mMeasured.end(); ++it) {
+        file << it->first << " " << it->second << "\n";
+    }
+    qDebug() << "Wrote" << updatedBaselineFile << ", copy it to" << baselineFile << "to update the baseline";
+}
+
+void AllocationTest::allocationTest_data()
+{
+    QTest::addColumn<int>("operation");
+    QTest::addColumn<QString>("type");
+
+    const char *types[] = {"event", "recurringevent", "todo", "journal", "freebusy", "contact", "distlist", "note", "configuration", "file"};
+    for (unsigned int i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        QTest::newRow(QString("read_%1").arg(types[i]).toLatin1().constData()) << static_cast<int>(Read) << QString(types[i]);
+        QTest::newRow(QString("write_%1").arg(types[i]).toLatin1().constData()) << static_cast<int>(Write) << QString(types[i]);
+    }
+}
+
+void AllocationTest::allocationTest()
+{
+    QFETCH(int, operation);
+    QFETCH(QString, type);
+
+    const std::string name = QTest::currentDataTag();
+    const Counts counts = countAllocations(static_cast<Operation>(operation), type.toStdString());
+    QVERIFY(counts.allocations > 0);
+    QVERIFY(counts.xercesAllocations > 0);
+    checkBaseline(name, counts.allocations);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+    checkBaseline("xerces_" + name, counts.xercesAllocations);
+}
+
+QTEST_MAIN( AllocationTest )
+
+#include "allocationtest.moc"
@@ -0,0 +1,52 @@
+/*
+    Copyright (C) 2012 Christian Mollekopf <mollekopf@kolabsys.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef ALLOCATIONTEST_H
+#define ALLOCATIONTEST_H
+
+#include <QObject>
+#include <map>
+#include <string>
+
+/*
+ * Counts the heap allocations (all of them, and those of Xerces) of reading and writing a canonical object of every type,
+ * and fails if a count grows beyond the baseline recorded in allocationbaseline.txt, or if the baseline lacks a row.
+ *
+ * The counts depend on the toolchain, so the baseline is only enforced for the configuration (compiler, Xerces, xsd and boost
+ * versions) it was recorded with, other configurations just print the counts.
+ * Run with KOLAB_UPDATE_ALLOCATION_BASELINE set to record the current counts in the build directory, and copy the file over
+ * tests/allocationbaseline.txt to make them the new baseline. The test is only registered with ctest once a baseline is recorded.
+ */
+class AllocationTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void allocationTest_data();
+    void allocationTest();
+private:
+    void checkBaseline(const std::string &name, unsigned long count);
+    std::string mBaselineConfiguration;
+    bool mGated;
+    std::map<std::string, unsigned long> mBaseline;
+    std::map<std::string, unsigned long> mMeasured;
+};
+
+#endif
@@ -0,0 +1,224 @@
+/*
+    Copyright (C) 2012 Christian Mollekopf <mollekopf@kolabsys.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "benchmarktest.h"
+
+#include <QtTest/QtTest>
+#include <src/kolabformat.h>
+#include "testobjects.h"
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <cstdlib>
+
+enum Kind {
+    EventKind,
+    RecurringEventKind,
+    TodoKind,
+    JournalKind,
+    FreebusyKind,
+    ContactKind,
+    DistlistKind,
+    NoteKind,
+    ConfigurationKind,
+    FileKind
+};
+
+enum Mode {
+    ReadMode,
+    WriteMode,
+    RoundtripMode
+};
+
+
+template <typename T>
+static void benchmark(Mode mode, const T &object)
+{
+    const T *type = 0;
+    const std::string serialized = write(object);
+    QCOMPARE(Kolab::error(), Kolab::NoError);
+    read(serialized, type);
+    QCOMPARE(Kolab::error(), Kolab::NoError);
+
+    switch (mode) {
+        case ReadMode:
+            QBENCHMARK {
+                read(serialized, type);
+            }
+            break;
+        case WriteMode:
+            QBENCHMARK {
+                write(object);
+            }
+            break;
+        case RoundtripMode:
+            QBENCHMARK {
+                read(write(object), type);
+            }
+            break;
+    }
+}
+
+static void addRows()
+{
+    QTest::addColumn<int>("kind");
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("event") << static_cast<int>(EventKind) << 0;
+    QTest::newRow("event recurring") << static_cast<int>(RecurringEventKind) << 0;
+    QTest::newRow("event 10 exceptions") << static_cast<int>(EventKind) << 10;
+    QTest::newRow("event 100 exceptions") << static_cast<int>(EventKind) << 100;
+    QTest::newRow("todo") << static_cast<int>(TodoKind) << 0;
+    QTest::newRow("journal") << static_cast<int>(JournalKind) << 0;
+    QTest::newRow("freebusy 10 periods") << static_cast<int>(FreebusyKind) << 10;
+    QTest::newRow("freebusy 1000 periods") << static_cast<int>(FreebusyKind) << 1000;
+    QTest::newRow("contact") << static_cast<int>(ContactKind) << 0;
+    QTest::newRow("contact 10k photo") << static_cast<int>(ContactKind) << 10 * 1024;
+    QTest::newRow("contact 1M photo") << static_cast<int>(ContactKind) << 1024 * 1024;
+    QTest::newRow("distlist 10 members") << static_cast<int>(DistlistKind) << 10;
+    QTest::newRow("distlist 1000 members") << static_cast<int>(DistlistKind) << 1000;
+    QTest::newRow("note") << static_cast<int>(NoteKind) << 0;
+    QTest::newRow("configuration 1000 entries") << static_cast<int>(ConfigurationKind) << 1000;
+    QTest::newRow("file 1k") << static_cast<int>(FileKind) << 1024;
+    QTest::newRow("file 1M") << static_cast<int>(FileKind) << 1024 * 1024;
+}
+
+static void run(Mode mode)
+{
+    QFETCH(int, kind);
+    QFETCH(int, size);
+
+    switch (kind) {
+        case EventKind:
+            benchmark(mode, createEvent(size, false));
+            break;
+        case RecurringEventKind:
+            benchmark(mode, createEvent(size, true));
+            break;
+        case TodoKind:
+            benchmark(mode, createTodo());
+            break;
+        case JournalKind:
+            benchmark(mode, createJournal());
+            break;
+        case FreebusyKind:
+            benchmark(mode, createFreebusy(size));
+            break;
+        case ContactKind:
+            benchmark(mode, createContact(size));
+            break;
+        case DistlistKind:
+            benchmark(mode, createDistlist(size));
+            break;
+        case NoteKind:
+            benchmark(mode, createNote());
+            break;
+        case ConfigurationKind:
+            benchmark(mode, createConfiguration(size));
+            break;
+        case FileKind:
+            benchmark(mode, createFile(size));
+            break;
+    }
+}
+
+void BenchmarkTest::readBenchmark_data()
+{
+    addRows();
+}
+
+void BenchmarkTest::readBenchmark()
+{
+    run(ReadMode);
+}
+
+void BenchmarkTest::writeBenchmark_data()
+{
+    addRows();
+}
+
+void BenchmarkTest::writeBenchmark()
+{
+    run(WriteMode);
+}
+
+void BenchmarkTest::roundtripBenchmark_data()
+{
+    addRows();
+}
+
+void BenchmarkTest::roundtripBenchmark()
+{
+    run(RoundtripMode);
+}
+
+static void mixedWorkload(const Kolab::Event &event, const std::string &serialized, int operations, boost::barrier &start)
+{
+    //Creating the parser of the thread is not part of the measurement
+    Kolab::readEvent(serialized, false);
+    start.wait();
+    for (int i = 0; i < operations; i++) {
+        //Clients read a lot more than they write
+        if (i % 4) {
+            Kolab::readEvent(serialized, false);
+        } else {
+            Kolab::writeEvent(event);
+        }
+    }
+}
+
+/**
+ * Returns the operations per second of all threads.
+ */
+static double throughput(int threads, const Kolab::Event &event, const std::string &serialized)
+{
+    const int operations = 200;
+    boost::barrier start(static_cast<unsigned int>(threads + 1));
+    boost::thread_group group;
+    for (int i = 0; i < threads; i++) {
+        group.create_thread(boost::bind(&mixedWorkload, boost::cref(event), boost::cref(serialized), operations, boost::ref(start)));
+    }
+    start.wait();
+    const boost::posix_time::ptime begin = boost::posix_time::microsec_clock::universal_time();
+    group.join_all();
+    const double seconds = static_cast<double>((boost::posix_time::microsec_clock::universal_time() - begin).total_microseconds()) / 1000000.0;
+    return threads * operations / seconds;
+}
+
+void BenchmarkTest::scalingBenchmark()
+{
+    const Kolab::Event event = createEvent(0, true);
+    const std::string serialized = Kolab::writeEvent(event);
+    QCOMPARE(Kolab::error(), Kolab::NoError);
+
+    const char *minEfficiency = getenv("KOLAB_MIN_SCALING_EFFICIENCY");
+    const int maxThreads = std::max(2, static_cast<int>(boost::thread::hardware_concurrency()));
+    const double single = throughput(1, event, serialized);
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        const double total = (threads == 1) ? single : throughput(threads, event, serialized);
+        const double efficiency = total / (threads * single);
+        qDebug() << "threads:" << threads << "operations/s:" << total << "efficiency:" << efficiency;
+        if (minEfficiency) {
+            QVERIFY2(efficiency >= atof(minEfficiency), QString("efficiency with %1 threads is %2").arg(threads).arg(efficiency).toLatin1().constData());
+        }
+    }
+}
+
+QTEST_MAIN( BenchmarkTest )
+
+#include "benchmarktest.moc"
@@ -0,0 +1,50 @@
+/*
+    Copyright (C) 2012 Christian Mollekopf <mollekopf@kolabsys.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef BENCHMARKTEST_H
+#define BENCHMARKTEST_H
+
+#include <QObject>
+
+/*
+ * Throughput of reading, writing and the roundtrip of every object type, in various sizes.
+ *
+ * Run "make benchmark" to get the results as xml (benchmark.xml in the build directory) for regression tracking.
+ * The startup costs are measured separately by coldstartbenchmark.
+ */
+class BenchmarkTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void readBenchmark_data();
+    void readBenchmark();
+    void writeBenchmark_data();
+    void writeBenchmark();
+    void roundtripBenchmark_data();
+    void roundtripBenchmark();
+
+    /**
+     * Throughput of a mixed read/write workload on 1..N threads (N being the number of cores).
+     *
+     * Reports the throughput and the efficiency per thread compared to a single thread.
+     * If KOLAB_MIN_SCALING_EFFICIENCY is set (i.e. to 0.7), the test fails if the efficiency drops below it.
+     */
+    void scalingBenchmark();
+};
+
+#endif
@@ -19,6 +19,14 @@
 #include <src/utils.h>
 #include "src/containers/kolabjournal.h"
 #include "libkolabxml-version.h"
+#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <map>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 void BindingsTest::categorycolorConfigurationCompletness()
 {
@@ -769,6 +777,42 @@ void BindingsTest::contactCompletness()
     QCOMPARE(e.customProperties(), c.customProperties());
 }
 
+void BindingsTest::contactEncodedBinaryData()
+{
+    Kolab::Contact c;
+    c.setEncodedPhoto("cGhvdG8=", "image/png");
+    std::vector<Kolab::Affiliation> affiliations;
+    affiliations.push_back(Kolab::Affiliation());
+    affiliations.push_back(Kolab::Affiliation());
+    c.setAffiliations(affiliations);
+    c.setEncodedAffiliationLogo(1, "bG9nbw==", "image/jpeg");
+    std::vector<Kolab::Key> keys;
+    keys.push_back(Kolab::Key("key1", Kolab::Key::PGP));
+    c.setKeys(keys);
+    c.addEncodedKey("a2V5Mg==", Kolab::Key::PKCS7_MIME);
+
+    //Copies share the not yet decoded values
+    const Kolab::Contact copy = c;
+    QCOMPARE(c.photo(), std::string("photo"));
+    QCOMPARE(c.photoMimetype(), std::string("image/png"));
+    QCOMPARE(copy.photo(), std::string("photo"));
+    QCOMPARE(copy.affiliations().size(), static_cast<std::size_t>(2));
+    QCOMPARE(copy.affiliations().at(0).logo(), std::string());
+    QCOMPARE(copy.affiliations().at(1).logo(), std::string("logo"));
+    QCOMPARE(copy.affiliations().at(1).logoMimetype(), std::string("image/jpeg"));
+    keys.push_back(Kolab::Key("key2", Kolab::Key::PKCS7_MIME));
+    QCOMPARE(copy.keys(), keys);
+
+    //Setting decoded values replaces the encoded ones
+    c.setPhoto("photo2", "image/gif");
+    QCOMPARE(c.photo(), std::string("photo2"));
+    QCOMPARE(copy.photo(), std::string("photo"));
+    c.setKeys(std::vector<Kolab::Key>());
+    QVERIFY(c.keys().empty());
+    c.setAffiliations(affiliations);
+    QCOMPARE(c.affiliations().at(1).logo(), std::string());
+}
+
 void BindingsTest::dateOnlyDates()
 {
     Kolab::Contact c;
@@ -837,6 +881,42 @@ void BindingsTest::generateTimestampIfEmpty()
     QVERIFY(retContact.lastModified().isUTC());
 }
 
+static Kolab::cDateTime fixedTimestamp()
+{
+    return Kolab::cDateTime(2012, 3, 4, 5, 6, 7, true);
+}
+
+void BindingsTest::timestampProvider()
+{
+    Kolab::setTimestampProvider(&fixedTimestamp);
+
+    Kolab::Event ev;
+    setIncidence(ev);
+    ev.setCreated(Kolab::cDateTime());
+    ev.setLastModified(Kolab::cDateTime());
+    Kolab::Event e = Kolab::readEvent(Kolab::writeEvent(ev), false);
+    QCOMPARE(e.created(), fixedTimestamp());
+    QCOMPARE(e.lastModified(), fixedTimestamp());
+
+    Kolab::Note note;
+    note.setUid("uid");
+    Kolab::Note n = Kolab::readNote(Kolab::writeNote(note), false);
+    QCOMPARE(n.created(), fixedTimestamp());
+    QCOMPARE(n.lastModified(), fixedTimestamp());
+
+    //An overridden timestamp takes precedence
+    const Kolab::cDateTime overridden(2011, 1, 1, 1, 1, 1, true);
+    Kolab::overrideTimestamp(overridden);
+    e = Kolab::readEvent(Kolab::writeEvent(ev), false);
+    QCOMPARE(e.lastModified(), overridden);
+    Kolab::overrideTimestamp(Kolab::cDateTime());
+
+    Kolab::setTimestampProvider(0);
+    e = Kolab::readEvent(Kolab::writeEvent(ev), false);
+    QVERIFY(e.lastModified().isValid());
+    QVERIFY(!(e.lastModified() == fixedTimestamp()));
+}
+
 void BindingsTest::versionTest()
 {
     Kolab::Todo ev;
@@ -870,6 +950,476 @@ void BindingsTest::errorRecoveryTest()
     QCOMPARE(Kolab::error(), Kolab::NoError);
 }
 
+void BindingsTest::diagnosticsTest()
+{
+    Kolab::readTodo("klbsdfbklsdbkl", false);
+    std::vector<Kolab::Diagnostic> diagnostics = Kolab::diagnostics();
+    QVERIFY(!diagnostics.empty());
+    QCOMPARE(diagnostics.front().code, Kolab::ParseError);
+    QCOMPARE(diagnostics.back().severity, Kolab::Critical);
+
+    Kolab::Todo todo;
+    setIncidence(todo);
+    std::string result = Kolab::writeTodo(todo);
+    QVERIFY(Kolab::diagnostics().empty());
+    Kolab::readTodo(result, false);
+    QVERIFY(Kolab::diagnostics().empty());
+
+    //A schema violation is reported with its position
+    const std::size_t pos = result.find("<uid>");
+    QVERIFY(pos != std::string::npos);
+    result.replace(pos, 5, "<xid>");
+    result.replace(result.find("</uid>"), 6, "</xid>");
+    Kolab::readTodo(result, false);
+    diagnostics = Kolab::diagnostics();
+    QVERIFY(!diagnostics.empty());
+    QCOMPARE(diagnostics.front().code, Kolab::ParseError);
+    QCOMPARE(diagnostics.front().severity, Kolab::Error);
+    QVERIFY(diagnostics.front().line > 0);
+    QVERIFY(!diagnostics.front().message.empty());
+    QCOMPARE(Kolab::error(), Kolab::Critical);
+
+    //The diagnostics of a single call, which are kept after the next call
+    std::vector<Kolab::Diagnostic> callDiagnostics;
+    Kolab::readTodo(result, false, &callDiagnostics);
+    Kolab::writeTodo(todo, std::string(), &diagnostics);
+    QVERIFY(diagnostics.empty());
+    QVERIFY(!callDiagnostics.empty());
+    QCOMPARE(callDiagnostics.front().code, Kolab::ParseError);
+    QVERIFY(callDiagnostics.front().line > 0);
+}
+
+void BindingsTest::phaseStatisticsTest()
+{
+    Kolab::setInstrumentationEnabled(true);
+    Kolab::resetPhaseStatistics();
+
+    Kolab::Event ev;
+    setIncidence(ev);
+    const std::string result = Kolab::writeEvent(ev);
+    Kolab::readEvent(result, false);
+    Kolab::setInstrumentationEnabled(false);
+
+    std::map<Kolab::Phase, Kolab::PhaseStatistics> phases;
+    BOOST_FOREACH(const Kolab::PhaseStatistics &s, Kolab::phaseStatistics()) {
+        QCOMPARE(s.type, Kolab::EventObject);
+        QVERIFY(s.totalTime >= s.maxTime);
+        phases[s.phase] = s;
+    }
+    //The parsing of the self-check is only accounted to the self-check
+    QCOMPARE(phases[Kolab::ParsePhase].count, 1ul);
+    QCOMPARE(phases[Kolab::BindPhase].count, 1ul);
+    QCOMPARE(phases[Kolab::ConvertPhase].count, 2ul);
+    QCOMPARE(phases[Kolab::ValidatePhase].count, 2ul);
+    QCOMPARE(phases[Kolab::SerializePhase].count, 1ul);
+    QCOMPARE(phases[Kolab::SelfCheckPhase].count, 1ul);
+
+    //Nothing is recorded while disabled
+    Kolab::readEvent(result, false);
+    QCOMPARE(Kolab::phaseStatistics().size(), phases.size());
+
+    Kolab::resetPhaseStatistics();
+    QVERIFY(Kolab::phaseStatistics().empty());
+}
+
+void BindingsTest::metricsTest()
+{
+    Kolab::resetMetrics();
+
+    Kolab::Event ev;
+    setIncidence(ev);
+    const std::string result = Kolab::writeEvent(ev);
+    Kolab::readEvent(result, false);
+    Kolab::readEvent("garbage", false);
+
+    const Kolab::MetricsSnapshot snapshot = Kolab::metricsSnapshot();
+    QCOMPARE(snapshot.writes(Kolab::EventObject), 1ul);
+    QCOMPARE(snapshot.reads(Kolab::EventObject), 2ul);
+    QCOMPARE(snapshot.reads(Kolab::TodoObject), 0ul);
+    QCOMPARE(snapshot.bytesWritten(Kolab::EventObject), static_cast<unsigned long>(result.size()));
+    QCOMPARE(snapshot.bytesRead(Kolab::EventObject), static_cast<unsigned long>(result.size() + 7));
+    QCOMPARE(snapshot.failedWrites(Kolab::EventObject, Kolab::Critical), 0ul);
+    QCOMPARE(snapshot.failedReads(Kolab::EventObject, Kolab::Critical), 1ul);
+    QVERIFY(snapshot.readLatency(Kolab::EventObject, 0.5) > 0);
+    QVERIFY(snapshot.readLatency(Kolab::EventObject, 1.0) >= snapshot.readLatency(Kolab::EventObject, 0.5));
+    QCOMPARE(snapshot.writeLatency(Kolab::TodoObject, 0.5), 0.0);
+
+    const std::string text = snapshot.toText();
+    QVERIFY(text.find("kolab_reads_total{type=\"event\"} 2\n") != std::string::npos);
+    QVERIFY(text.find("kolab_writes_total{type=\"event\"} 1\n") != std::string::npos);
+    QVERIFY(text.find("type=\"todo\"") == std::string::npos);
+
+    Kolab::resetMetrics();
+    QCOMPARE(Kolab::metricsSnapshot().reads(Kolab::EventObject), 0ul);
+    QVERIFY(Kolab::metricsSnapshot().toText().empty());
+}
+
+void BindingsTest::memoryAccountingTest()
+{
+    Kolab::Event ev;
+    setIncidence(ev);
+    Kolab::setMemoryAccountingEnabled(true);
+    const std::string result = Kolab::writeEvent(ev);
+    QVERIFY(!Kolab::errorOccurred());
+    const Kolab::MemoryStatistics write = Kolab::lastOperationMemory();
+    QVERIFY(write.allocations > 0);
+    QVERIFY(write.allocatedBytes >= write.peakBytes);
+    QVERIFY(write.peakBytes > 0);
+
+    Kolab::readEvent(result, false);
+    QVERIFY(!Kolab::errorOccurred());
+    const Kolab::MemoryStatistics read = Kolab::lastOperationMemory();
+    QVERIFY(read.allocations > 0);
+    QVERIFY(read.peakBytes > 0);
+    QVERIFY(Kolab::threadPeakMemory() >= read.peakBytes);
+
+    //More attendees need more memory
+    for (int i = 0; i < 100; i++) {
+        Kolab::Attendee attendee(Kolab::ContactReference("mail@example.org", "name", "uid"));
+        ev.setAttendees(ev.attendees() << attendee);
+    }
+    Kolab::readEvent(Kolab::writeEvent(ev), false);
+    QVERIFY(Kolab::lastOperationMemory().peakBytes > read.peakBytes);
+
+    //Rejected like for the other resource limits
+    Kolab::setMemoryBudget(read.peakBytes / 2);
+    QVERIFY(Kolab::readEvent(result, false).uid().empty());
+    Kolab::setMemoryBudget(0);
+    QCOMPARE(Kolab::error(), Kolab::Critical);
+    bool found = false;
+    BOOST_FOREACH(const Kolab::Diagnostic &d, Kolab::diagnostics()) {
+        if (d.code == Kolab::ResourceLimitError) {
+            found = true;
+        }
+    }
+    QVERIFY(found);
+
+    Kolab::readEvent(result, false);
+    QVERIFY(!Kolab::errorOccurred());
+
+    //The statistics are not updated while disabled
+    Kolab::setMemoryAccountingEnabled(false);
+    const unsigned long allocations = Kolab::lastOperationMemory().allocations;
+    Kolab::writeEvent(ev);
+    QCOMPARE(Kolab::lastOperationMemory().allocations, allocations);
+}
+
+static bool resourceLimitExceeded()
+{
+    if (Kolab::error() != Kolab::Critical) {
+        return false;
+    }
+    BOOST_FOREACH(const Kolab::Diagnostic &d, Kolab::diagnostics()) {
+        if (d.code == Kolab::ResourceLimitError) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BindingsTest::resourceLimitsTest()
+{
+    Kolab::Event ev;
+    ev.setUid("uid1");
+    ev.setStart(Kolab::cDateTime("Europe/Zurich", 2006,1,8,12,0,0));
+    Kolab::Attachment attachment;
+    attachment.setData(std::string(3000, 'a'), "mimetype");
+    ev.setAttachments(std::vector<Kolab::Attachment>() << attachment);
+    std::vector<Kolab::Event> exceptions;
+    for (int i = 0; i < 3; i++) {
+        Kolab::Event ex;
+        ex.setStart(Kolab::cDateTime("Europe/Zurich", 2006,1,8 + i,12,0,0));
+        ex.setUid("uid1");
+        ex.setRecurrenceID(Kolab::cDateTime("Europe/Zurich", 2006,1,8 + i,12,0,0), false);
+        exceptions.push_back(ex);
+    }
+    ev.setExceptions(exceptions);
+    const std::string result = Kolab::writeEvent(ev);
+    QVERIFY(!Kolab::errorOccurred());
+
+    Kolab::ResourceLimits limits;
+    limits.maxInputSize = result.size() * 2;
+    limits.maxElementCount = 10000;
+    limits.maxAttachmentSize = 3000;
+    limits.maxExceptions = 3;
+    limits.maxTime = 10000;
+    Kolab::setResourceLimits(limits);
+    Kolab::readEvent(result, false);
+    QCOMPARE(Kolab::error(), Kolab::NoError);
+
+    Kolab::ResourceLimits exceeded = limits;
+    exceeded.maxInputSize = result.size() - 1;
+    Kolab::setResourceLimits(exceeded);
+    Kolab::readEvent(result, false);
+    QVERIFY(resourceLimitExceeded());
+
+    exceeded = limits;
+    exceeded.maxElementCount = 10;
+    Kolab::setResourceLimits(exceeded);
+    Kolab::readEvent(result, false);
+    QVERIFY(resourceLimitExceeded());
+
+    //The object is rejected as a whole, not returned without the attachment
+    exceeded = limits;
+    exceeded.maxAttachmentSize = 1000;
+    Kolab::setResourceLimits(exceeded);
+    QVERIFY(Kolab::readEvent(result, false).uid().empty());
+    QVERIFY(resourceLimitExceeded());
+
+    Kolab::setResourceLimits(Kolab::ResourceLimits());
+    Kolab::Note note;
+    note.setUid("uid1");
+    note.setAttachments(std::vector<Kolab::Attachment>() << attachment);
+    const std::string noteResult = Kolab::writeNote(note);
+    Kolab::Contact contact;
+    contact.setUid("uid1");
+    contact.setPhoto(std::string(3000, 'a'), "image/png");
+    const std::string contactResult = Kolab::writeContact(contact);
+    Kolab::setResourceLimits(exceeded);
+    QVERIFY(Kolab::readNote(noteResult, false).uid().empty());
+    QVERIFY(resourceLimitExceeded());
+    QVERIFY(Kolab::readContact(contactResult, false).uid().empty());
+    QVERIFY(resourceLimitExceeded());
+
+    exceeded = limits;
+    exceeded.maxExceptions = 2;
+    Kolab::setResourceLimits(exceeded);
+    QVERIFY(Kolab::readEvent(result, false).uid().empty());
+    QVERIFY(resourceLimitExceeded());
+
+    Kolab::setResourceLimits(Kolab::ResourceLimits());
+    Kolab::readEvent(result, false);
+    QCOMPARE(Kolab::error(), Kolab::NoError);
+}
+
+static std::vector<Kolab::TraceInfo> traceBegins;
+static std::vector<Kolab::TraceInfo> traceEnds;
+
+static void traceBegin(const Kolab::TraceInfo &info)
+{
+    traceBegins.push_back(info);
+}
+
+static void traceEnd(const Kolab::TraceInfo &info)
+{
+    traceEnds.push_back(info);
+}
+
+static void reentrantTraceBegin(const Kolab::TraceInfo &info)
+{
+    if (std::string(info.operation) == "loadGrammar") {
+        //Calls back into the library
+        Kolab::setParserPool(0);
+        traceBegins.push_back(info);
+    }
+}
+
+void BindingsTest::tracerTest()
+{
+    Kolab::Event ev;
+    setIncidence(ev);
+    Kolab::setTracer(&traceBegin, &traceEnd);
+    const std::string result = Kolab::writeEvent(ev);
+    Kolab::readEvent(result, false);
+    Kolab::setTracer(0, 0);
+    Kolab::readEvent(result, false);
+
+    //The grammar has already been loaded by the previous tests
+    QCOMPARE(traceBegins.size(), std::size_t(3));
+    QCOMPARE(traceEnds.size(), std::size_t(3));
+
+    //The self-check is nested in the write
+    QCOMPARE(std::string(traceBegins.at(0).operation), std::string("write"));
+    QCOMPARE(std::string(traceBegins.at(1).operation), std::string("selfCheck"));
+    QCOMPARE(std::string(traceEnds.at(0).operation), std::string("selfCheck"));
+    QCOMPARE(std::string(traceEnds.at(1).operation), std::string("write"));
+    QCOMPARE(traceEnds.at(1).type, Kolab::EventObject);
+    QCOMPARE(traceEnds.at(1).uid, ev.uid());
+    QCOMPARE(traceEnds.at(1).size, static_cast<unsigned long>(result.size()));
+    QCOMPARE(traceEnds.at(1).result, Kolab::NoError);
+    QCOMPARE(traceBegins.at(1).uid, ev.uid());
+    QCOMPARE(traceEnds.at(0).uid, ev.uid());
+
+    QCOMPARE(std::string(traceBegins.at(2).operation), std::string("read"));
+    QCOMPARE(traceBegins.at(2).size, static_cast<unsigned long>(result.size()));
+    QVERIFY(traceBegins.at(2).uid.empty());
+    QCOMPARE(std::string(traceEnds.at(2).operation), std::string("read"));
+    QCOMPARE(traceEnds.at(2).uid, ev.uid());
+    traceBegins.clear();
+    traceEnds.clear();
+
+    //A generated UID is reported as well
+    ev.setUid(std::string());
+    Kolab::setTracer(&traceBegin, &traceEnd);
+    Kolab::writeEvent(ev);
+    Kolab::setTracer(0, 0);
+    QCOMPARE(traceEnds.size(), std::size_t(2));
+    QVERIFY(!traceEnds.at(1).uid.empty());
+    QCOMPARE(traceEnds.at(1).uid, Kolab::getSerializedUID());
+    QCOMPARE(traceEnds.at(0).uid, traceEnds.at(1).uid);
+    traceBegins.clear();
+    traceEnds.clear();
+}
+
+void BindingsTest::initializeTest()
+{
+    QVERIFY(Kolab::initialize(1));
+    QVERIFY(Kolab::initialize());
+    Kolab::shutdown();
+
+    Kolab::Event ev;
+    setIncidence(ev);
+    const std::string result = Kolab::writeEvent(ev);
+    QCOMPARE(Kolab::error(), Kolab::NoError);
+    QCOMPARE(Kolab::readEvent(result, false).uid(), ev.uid());
+    QCOMPARE(Kolab::error(), Kolab::NoError);
+    //The warm-up doesn't change the uid of the last write
+    QVERIFY(Kolab::initialize());
+    QCOMPARE(Kolab::getSerializedUID(), ev.uid());
+    Kolab::shutdown();
+    Kolab::shutdown();
+
+    //Everything has been released, so initialize() loads the grammar again (and the read doesn't)
+    Kolab::setTracer(&traceBegin, &traceEnd);
+    QVERIFY(Kolab::initialize());
+    Kolab::readEvent(result, false);
+    Kolab::setTracer(0, 0);
+    QCOMPARE(traceBegins.size(), std::size_t(2));
+    QCOMPARE(std::string(traceBegins.at(0).operation), std::string("loadGrammar"));
+    QCOMPARE(std::string(traceBegins.at(1).operation), std::string("read"));
+    traceBegins.clear();
+    traceEnds.clear();
+    Kolab::shutdown();
+
+    //The library is still usable after the shutdown, and the grammar is loaded again without holding a lock on the hooks
+    Kolab::setTracer(&reentrantTraceBegin, 0);
+    QCOMPARE(Kolab::readEvent(result, false).uid(), ev.uid());
+    Kolab::setTracer(0, 0);
+    QCOMPARE(Kolab::error(), Kolab::NoError);
+    QCOMPARE(traceBegins.size(), std::size_t(1));
+    traceBegins.clear();
+}
+
+static void readInThread(const std::string *document)
+{
+    Kolab::readEvent(*document, false);
+}
+
+void BindingsTest::threadChurnTest()
+{
+    Kolab::Event ev;
+    setIncidence(ev);
+    const std::string result = Kolab::writeEvent(ev);
+
+    //Xerces stays initialized and the grammar loaded while threads come and go
+    Kolab::setTracer(&traceBegin, &traceEnd);
+    for (int i = 0; i < 3; i++) {
+        boost::thread thread(boost::bind(&readInThread, &result));
+        thread.join();
+    }
+    Kolab::setTracer(0, 0);
+    QCOMPARE(traceBegins.size(), std::size_t(3));
+    BOOST_FOREACH(const Kolab::TraceInfo &info, traceEnds) {
+        QCOMPARE(std::string(info.operation), std::string("read"));
+        QCOMPARE(info.result, Kolab::NoError);
+    }
+    traceBegins.clear();
+    traceEnds.clear();
+}
+
+void BindingsTest::forkTest()
+{
+#ifndef _WIN32
+    Kolab::Event ev;
+    setIncidence(ev);
+    const std::string result = Kolab::writeEvent(ev);
+    QVERIFY(Kolab::initialize());
+    const std::string parentUid = Kolab::generateUID();
+
+    int fds[2];
+    QVERIFY(pipe(fds) == 0);
+    const pid_t pid = fork();
+    QVERIFY(pid >= 0);
+    if (!pid) {
+        //The child reuses the grammar and the parser of the parent, and generates its own uids
+        Kolab::setTracer(&traceBegin, &traceEnd);
+        const bool ok = Kolab::readEvent(result, false).uid() == ev.uid() && Kolab::error() == Kolab::NoError;
+        const std::string message = (ok && traceBegins.size() == 1 ? "ok " : "failed ") + Kolab::generateUID();
+        if (write(fds[1], message.data(), message.size()) < 0) {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    char buffer[128];
+    const ssize_t size = read(fds[0], buffer, sizeof(buffer));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    const std::string nextParentUid = Kolab::generateUID();
+    Kolab::shutdown();
+
+    QVERIFY(size > 0);
+    const std::string message(buffer, static_cast<std::size_t>(size));
+    QCOMPARE(message.substr(0, 3), std::string("ok "));
+    QVERIFY(message.substr(3) != parentUid);
+    QVERIFY(message.substr(3) != nextParentUid);
+#endif
+}
+
+static boost::mutex readsMutex;
+static int successfulReads = 0;
+
+static void countRead(const std::string *document)
+{
+    Kolab::readEvent(*document, false);
+    const bool success = Kolab::error() == Kolab::NoError;
+    boost::mutex::scoped_lock lock(readsMutex);
+    successfulReads += success ? 1 : 0;
+}
+
+void BindingsTest::parserPoolTest()
+{
+    Kolab::Event ev;
+    setIncidence(ev);
+    const std::string result = Kolab::writeEvent(ev);
+    Kolab::setMemoryAccountingEnabled(true);
+
+    //Without a pool, releasing the parser of the thread makes the next read create one again
+    Kolab::readEvent(result, false);
+    Kolab::readEvent(result, false);
+    const unsigned long warm = Kolab::lastOperationMemory().allocations;
+    Kolab::releaseThreadResources();
+    Kolab::readEvent(result, false);
+    QCOMPARE(Kolab::error(), Kolab::NoError);
+    QVERIFY(Kolab::lastOperationMemory().allocations > warm);
+
+    //More threads than parsers
+    Kolab::setParserPool(2);
+    successfulReads = 0;
+    boost::thread_group threads;
+    for (int i = 0; i < 8; i++) {
+        threads.create_thread(boost::bind(&countRead, &result));
+    }
+    threads.join_all();
+    QCOMPARE(successfulReads, 8);
+
+    //A returned parser is reused until it expires
+    Kolab::setParserPool(1, 50);
+    Kolab::readEvent(result, false);
+    Kolab::readEvent(result, false);
+    const unsigned long pooled = Kolab::lastOperationMemory().allocations;
+    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    Kolab::readEvent(result, false);
+    QCOMPARE(Kolab::error(), Kolab::NoError);
+    QVERIFY(Kolab::lastOperationMemory().allocations > pooled);
+
+    Kolab::setParserPool(0);
+    QCOMPARE(Kolab::readEvent(result, false).uid(), ev.uid());
+    QCOMPARE(Kolab::error(), Kolab::NoError);
+    Kolab::setMemoryAccountingEnabled(false);
+}
+
 void BindingsTest::BenchmarkRoundtripKolab()
 {
     const Kolab::Event &event = Kolab::readEvent(TEST_DATA_PATH "/testfiles/icalEvent.xml", true);
@@ -891,6 +1441,59 @@ void BindingsTest::BenchmarkRoundtrip()
     }
 }
 
+void BindingsTest::BenchmarkRoundtripContactPhoto()
+{
+    Kolab::Contact contact;
+    contact.setUid("uid");
+    contact.setName("name");
+    std::string photo;
+    for (int i = 0; i < 1024 * 1024; i++) {
+        photo.push_back(static_cast<char>(i * 7));
+    }
+    contact.setPhoto(photo, "image/jpeg");
+    std::vector<Kolab::Key> keys;
+    keys.push_back(Kolab::Key(photo.substr(0, 4096), Kolab::Key::PGP));
+    keys.push_back(Kolab::Key(photo.substr(0, 4096), Kolab::Key::PKCS7_MIME));
+    contact.setKeys(keys);
+    const std::string result = Kolab::writeContact(contact);
+    QVERIFY(!Kolab::errorOccurred());
+    QBENCHMARK {
+        const Kolab::Contact &re = Kolab::readContact(result, false);
+        QCOMPARE(re.photo().size(), photo.size());
+    }
+    const Kolab::Contact &re = Kolab::readContact(result, false);
+    QCOMPARE(re.photo(), photo);
+    QCOMPARE(re.keys(), keys);
+}
+
+void BindingsTest::BenchmarkRoundtripManyAttendees()
+{
+    Kolab::Event event;
+    event.setUid("uid");
+    event.setStart(Kolab::cDateTime(2011,10,10,12,1,1,true));
+    event.setOrganizer(Kolab::ContactReference("organizer@example.org", "Organizer, The", "uid"));
+    std::vector<Kolab::Attendee> attendees;
+    for (int i = 0; i < 500; i++) {
+        const std::string number = QByteArray::number(i).constData();
+        Kolab::Attendee attendee(Kolab::ContactReference("attendee_" + number + "@example.org", "Attendee " + number));
+        attendee.setPartStat((i % 2) ? Kolab::PartAccepted : Kolab::PartTentative);
+        attendee.setRole((i % 3) ? Kolab::Required : Kolab::Optional);
+        if (!(i % 10)) {
+            attendee.setCutype(Kolab::CutypeRoom);
+        }
+        attendees.push_back(attendee);
+    }
+    event.setAttendees(attendees);
+    std::string result = Kolab::writeEvent(event);
+    QVERIFY(!Kolab::errorOccurred());
+    QBENCHMARK {
+        result = Kolab::writeEvent(event);
+        Kolab::readEvent(result, false);
+    }
+    const Kolab::Event &re = Kolab::readEvent(result, false);
+    QCOMPARE(re.attendees(), attendees);
+}
+
 void BindingsTest::preserveLatin1()
 {
     Kolab::Event event;
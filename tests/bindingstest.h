@@ -38,17 +38,31 @@ class BindingsTest : public QObject
     void freebusyCompletness();
     
     void contactCompletness();
+    void contactEncodedBinaryData();
     void dateOnlyDates();
     void distlistCompletness();
 
     void generateTimestampIfEmpty();
+    void timestampProvider();
 
     void versionTest();
     void errorTest();
     void errorRecoveryTest();
+    void diagnosticsTest();
+    void phaseStatisticsTest();
+    void metricsTest();
+    void memoryAccountingTest();
+    void resourceLimitsTest();
+    void tracerTest();
+    void initializeTest();
+    void threadChurnTest();
+    void forkTest();
+    void parserPoolTest();
 
     void BenchmarkRoundtripKolab();
     void BenchmarkRoundtrip();
+    void BenchmarkRoundtripContactPhoto();
+    void BenchmarkRoundtripManyAttendees();
 
     void preserveLatin1();
     void preserveUnicode();
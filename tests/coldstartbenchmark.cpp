@@ -0,0 +1,139 @@
+/*
+    Copyright (C) 2012 Christian Mollekopf <mollekopf@kolabsys.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+ * Measures the startup costs which are paid by the first read of the process, and partly by the first read on every thread:
+ * - starting a process which loads the library (and Xerces)
+ * - initializing Xerces (XMLPlatformUtils::Initialize)
+ * - deserializing the precompiled grammar (once per process, the grammar pool is shared by the parsers of all threads)
+ * - the first read of an object, on the main thread and on a new thread, compared to a warm read
+ *
+ * Prints one line per measurement: "<name> <microseconds>", or writes them to the file given as argument.
+ * POSIX only (fork/exec and clock_gettime), it is not built on other platforms.
+ */
+
+#include <src/kolabformat.h>
+#include <xercesc/util/PlatformUtils.hpp>
+#include <boost/thread.hpp>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <time.h>
+
+static unsigned long long now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long long>(ts.tv_sec) * 1000000ull + static_cast<unsigned long long>(ts.tv_nsec) / 1000ull;
+}
+
+static unsigned long long grammarTime = 0;
+
+//The grammar is loaded under a lock, so its hooks are only called afterwards and the duration is taken from the trace
+static void traceEnd(const Kolab::TraceInfo &info)
+{
+    if (std::string(info.operation) == "loadGrammar") {
+        grammarTime = info.duration / 1000;
+    }
+}
+
+/**
+ * The fastest of several starts of this executable, which exits right away.
+ */
+static unsigned long long processStart(const char *executable)
+{
+    unsigned long long fastest = 0;
+    for (int i = 0; i < 5; i++) {
+        const unsigned long long start = now();
+        const pid_t pid = fork();
+        if (pid == 0) {
+            execl(executable, executable, "--exit", static_cast<char*>(0));
+            _exit(1);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        const unsigned long long time = now() - start;
+        if (!fastest || time < fastest) {
+            fastest = time;
+        }
+    }
+    return fastest;
+}
+
+static void timedRead(const std::string *document, unsigned long long *time)
+{
+    const unsigned long long start = now();
+    Kolab::readEvent(*document, false);
+    *time = now() - start;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::string(argv[1]) == "--exit") {
+        return 0;
+    }
+
+    std::ifstream file(TEST_DATA_PATH "/testfiles/icalEvent.xml");
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string document = buffer.str();
+
+    std::ostringstream results;
+    results << "process_start " << processStart(argv[0]) << "\n";
+
+    unsigned long long start = now();
+    xercesc::XMLPlatformUtils::Initialize();
+    results << "xerces_initialize " << now() - start << "\n";
+
+    Kolab::setTracer(0, &traceEnd);
+    unsigned long long firstRead = 0;
+    timedRead(&document, &firstRead);
+    if (Kolab::errorOccurred()) {
+        std::cerr << "Failed to read the event: " << Kolab::errorMessage() << std::endl;
+        return -1;
+    }
+    results << "grammar_load " << grammarTime << "\n";
+    results << "first_read " << firstRead << "\n";
+
+    unsigned long long warmRead = 0;
+    timedRead(&document, &warmRead);
+    results << "warm_read " << warmRead << "\n";
+
+    //A new thread creates its own parser, but reuses the loaded grammar (grammar_load_new_thread is 0 unless it is reloaded)
+    grammarTime = 0;
+    unsigned long long threadRead = 0;
+    boost::thread thread(&timedRead, &document, &threadRead);
+    thread.join();
+    results << "first_read_new_thread " << threadRead << "\n";
+    results << "grammar_load_new_thread " << grammarTime << "\n";
+    Kolab::setTracer(0, 0);
+
+    xercesc::XMLPlatformUtils::Terminate();
+
+    if (argc > 1) {
+        std::ofstream output(argv[1]);
+        output << results.str();
+    } else {
+        std::cout << results.str();
+    }
+    return 0;
+}
@@ -4,10 +4,15 @@
 #include <src/xcalconversions.h>
 #include <src/xcardconversions.h>
 #include <src/utils.h>
+#include <src/uriencode.h>
+#include <src/numericstrings.h>
 
 #include "serializers.h"
 #include <boost/thread.hpp>
-#include <curl/curlver.h>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <set>
+#include <climits>
 
 Q_DECLARE_METATYPE(Kolab::Duration);
 Q_DECLARE_METATYPE(Kolab::DayPos);
@@ -33,6 +38,10 @@ void ConversionTest::durationParserTest_data()
     QTest::newRow("Day") << Kolab::Duration(1,2,3,4, false) << "+P1DT2H3M4S";
     QTest::newRow("Week") << Kolab::Duration(1, false) << "+P1W";
     QTest::newRow("Week Multidigit, negative") << Kolab::Duration(23, true) << "-P23W";
+    QTest::newRow("Minutes only") << Kolab::Duration(0,0,15,0, false) << "PT15M";
+    QTest::newRow("Leading zeros") << Kolab::Duration(0,0,15,0, false) << "PT015M";
+    QTest::newRow("Days only, negative") << Kolab::Duration(2,0,0,0, true) << "-P2D";
+    QTest::newRow("Largest") << Kolab::Duration(2147483647,0,0,0, false) << "P2147483647D";
     Kolab::Utils::clearErrors();
 }
 
@@ -67,6 +76,111 @@ void ConversionTest::durationSerializerTest()
     QCOMPARE(Kolab::Utils::getError(), Kolab::NoError);
 }
 
+void ConversionTest::durationParserErrorTest_data()
+{
+    QTest::addColumn<QString>("string");
+
+    QTest::newRow("Missing number") << "PTH";
+    QTest::newRow("Invalid designator") << "P1X";
+    QTest::newRow("Overflow") << "P2147483648D";
+    QTest::newRow("Overflow many digits") << "PT99999999999999999999S";
+}
+
+void ConversionTest::durationParserErrorTest()
+{
+    QFETCH(QString, string);
+    Kolab::Utils::clearErrors();
+    const Kolab::Duration result = toDuration(string.toStdString());
+    QVERIFY(!result.isValid());
+    QCOMPARE(Kolab::Utils::getError(), Kolab::Error);
+    Kolab::Utils::clearErrors();
+}
+
+//Duration::operator== compares the total number of seconds, which overflows for the large values we test with
+#define COMPARE_DURATION(result, expected) \
+    QCOMPARE(result.weeks(), expected.weeks()); \
+    QCOMPARE(result.days(), expected.days()); \
+    QCOMPARE(result.hours(), expected.hours()); \
+    QCOMPARE(result.minutes(), expected.minutes()); \
+    QCOMPARE(result.seconds(), expected.seconds()); \
+    QCOMPARE(result.isNegative(), expected.isNegative()); \
+    QCOMPARE(result.isValid(), expected.isValid());
+
+void ConversionTest::durationRoundtripTest()
+{
+    const int values[] = { 0, 1, 9, 10, 59, 60, 99, 100, 1000, 65535, 1000000, 2147483647 };
+    const int count = sizeof(values) / sizeof(values[0]);
+    Kolab::Utils::clearErrors();
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < count; j += 3) {
+            for (int negative = 0; negative < 2; negative++) {
+                const Kolab::Duration weeks(values[i], negative);
+                COMPARE_DURATION(toDuration(fromDuration(weeks)), weeks);
+                const Kolab::Duration time(values[i], values[j], values[count - 1 - i], values[count - 1 - j], negative);
+                COMPARE_DURATION(toDuration(fromDuration(time)), time);
+            }
+        }
+        for (int weekday = Kolab::Monday; weekday <= Kolab::Sunday; weekday++) {
+            const Kolab::DayPos pos(values[i], static_cast<Kolab::Weekday>(weekday));
+            QCOMPARE(toDayPos(fromDayPos(pos)), pos);
+            const Kolab::DayPos neg(-values[i], static_cast<Kolab::Weekday>(weekday));
+            QCOMPARE(toDayPos(fromDayPos(neg)), neg);
+        }
+    }
+    QCOMPARE(Kolab::Utils::getError(), Kolab::NoError);
+}
+
+void ConversionTest::numericStringTest()
+{
+    const int limits[] = { INT_MIN, INT_MIN + 1, INT_MAX, INT_MAX - 1, 0, -1 };
+    std::vector<int> values(limits, limits + sizeof(limits) / sizeof(limits[0]));
+    for (int i = 1; i < 1000000000; i = i * 3 + 1) {
+        values.push_back(i);
+        values.push_back(-i);
+        values.push_back(i + 1);
+        values.push_back(-(i + 1));
+    }
+    BOOST_FOREACH(int value, values) {
+        const std::string expected = boost::lexical_cast<std::string>(value);
+        std::string formatted;
+        appendInt(formatted, value);
+        QCOMPARE(formatted, expected);
+
+        int parsed = 0;
+        const char *end = parseInt(formatted.data(), formatted.data() + formatted.size(), parsed);
+        QVERIFY(end == formatted.data() + formatted.size());
+        QCOMPARE(parsed, value);
+    }
+
+    const char *invalid[] = { "", "+", "-", "a1", "2147483648", "-2147483649", "99999999999" };
+    for (std::size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        const std::string s(invalid[i]);
+        int parsed = 42;
+        QVERIFY(parseInt(s.data(), s.data() + s.size(), parsed) == s.data());
+        QCOMPARE(parsed, 42);
+    }
+
+    //Parsing stops at the first non-digit
+    const std::string prefix("-15WE");
+    int parsed = 0;
+    QVERIFY(parseInt(prefix.data(), prefix.data() + prefix.size(), parsed) == prefix.data() + 3);
+    QCOMPARE(parsed, -15);
+}
+
+void ConversionTest::durationBenchmark()
+{
+    const Kolab::Duration trigger(0, 0, 15, 0, true);
+    const Kolab::Duration duration(1, 2, 30, 45, false);
+    const Kolab::DayPos daypos(-1, Kolab::Sunday);
+    QBENCHMARK {
+        for (int i = 0; i < 1000; i++) {
+            toDuration(fromDuration(trigger));
+            toDuration(fromDuration(duration));
+            toDayPos(fromDayPos(daypos));
+        }
+    }
+}
+
 
 void ConversionTest::dayPosParserTest_data()
 {
@@ -77,6 +191,8 @@ void ConversionTest::dayPosParserTest_data()
     QTest::newRow("positive with +") << Kolab::DayPos(15, Kolab::Wednesday) << "+15WE";
     QTest::newRow("negative") << Kolab::DayPos(-15, Kolab::Wednesday) << "-15WE";
     QTest::newRow("all occurrences") << Kolab::DayPos(0, Kolab::Wednesday) << "WE";
+    QTest::newRow("last") << Kolab::DayPos(-1, Kolab::Sunday) << "-1SU";
+    QTest::newRow("multidigit") << Kolab::DayPos(53, Kolab::Monday) << "+53MO";
     Kolab::Utils::clearErrors();
 }
 
@@ -97,6 +213,8 @@ void ConversionTest::dayPosSerializerTest_data()
     QTest::newRow("pos") << "15WE" << Kolab::DayPos(15, Kolab::Wednesday);
     QTest::newRow("negative") << "-15WE" << Kolab::DayPos(-15, Kolab::Wednesday);
     QTest::newRow("all occurrences") << "WE" << Kolab::DayPos(0, Kolab::Wednesday);
+    QTest::newRow("last") << "-1SU" << Kolab::DayPos(-1, Kolab::Sunday);
+    QTest::newRow("multidigit") << "53MO" << Kolab::DayPos(53, Kolab::Monday);
     Kolab::Utils::clearErrors();
 
 }
@@ -169,6 +287,60 @@ void ConversionTest::uriInlineEncodingTest()
     QCOMPARE(mimetype, std::string("mimetype/mime"));
     QCOMPARE(d, std::string("data"));
     QCOMPARE(Kolab::Utils::getError(), Kolab::NoError);
+
+    //Binary data of all possible lengths modulo 3
+    std::string binary;
+    for (int i = 0; i < 256; i++) {
+        binary.push_back(static_cast<char>(i));
+        const std::string &encoded = Kolab::Utils::uriInlineEncoding(binary, "application/octet-stream");
+        QCOMPARE(Kolab::Utils::uriInlineDecoding(encoded, mimetype), binary);
+    }
+    QCOMPARE(mimetype, std::string("application/octet-stream"));
+
+    Kolab::Utils::InlineDataUri parts;
+    QVERIFY(Kolab::Utils::parseInlineDataUri(s, parts));
+    QVERIFY(Kolab::Utils::inlineMimetypeEquals(s, parts, "mimetype/mime"));
+    QVERIFY(!Kolab::Utils::inlineMimetypeEquals(s, parts, "mimetype/mim"));
+    QCOMPARE(Kolab::Utils::getError(), Kolab::NoError);
+
+    QCOMPARE(Kolab::Utils::uriInlineDecoding("http://example.org/photo.png", mimetype), std::string());
+    QCOMPARE(Kolab::Utils::getError(), Kolab::Error);
+    Kolab::Utils::clearErrors();
+    QCOMPARE(Kolab::Utils::uriInlineDecoding("data:image/png,abc", mimetype), std::string());
+    QCOMPARE(Kolab::Utils::getError(), Kolab::Error);
+    Kolab::Utils::clearErrors();
+}
+
+void ConversionTest::uriEncodingTest_data()
+{
+    QTest::addColumn<std::string>("decoded");
+    QTest::addColumn<std::string>("encoded");
+
+    QTest::newRow("Empty") << std::string() << std::string();
+    QTest::newRow("Unreserved") << std::string("AZaz09-._~") << std::string("AZaz09-._~");
+    QTest::newRow("Reserved") << std::string("!*'();:@&=+$,/?#[]") << std::string("%21%2A%27%28%29%3B%3A%40%26%3D%2B%24%2C%2F%3F%23%5B%5D");
+    QTest::newRow("Space and percent") << std::string("a b%c") << std::string("a%20b%25c");
+    QTest::newRow("UTF-8") << std::string("J\xc3\xb6rg") << std::string("J%C3%B6rg");
+    QTest::newRow("Control characters") << std::string("\x01\x7f\xff") << std::string("%01%7F%FF");
+}
+
+void ConversionTest::uriEncodingTest()
+{
+    QFETCH(std::string, decoded);
+    QFETCH(std::string, encoded);
+    QCOMPARE(uriEncode(decoded), encoded);
+    QCOMPARE(uriDecode(encoded), decoded);
+}
+
+void ConversionTest::uriDecodingTest()
+{
+    //Lowercase and unnecessarily encoded characters
+    QCOMPARE(uriDecode("%c3%b6%5F%2E%41"), std::string("\xc3\xb6_.A"));
+    //Incomplete or invalid escape sequences are kept as they are
+    QCOMPARE(uriDecode("%"), std::string("%"));
+    QCOMPARE(uriDecode("a%4"), std::string("a%4"));
+    QCOMPARE(uriDecode("%%41%zz"), std::string("%A%zz"));
+    QCOMPARE(uriDecode("+"), std::string("+"));
 }
 
 void ConversionTest::mailtoUriEncodingTest_data()
@@ -176,16 +348,10 @@ void ConversionTest::mailtoUriEncodingTest_data()
     QTest::addColumn<QString>("email");
     QTest::addColumn<QString>("name");
     QTest::addColumn<QString>("resultEncoded");
-    //Older versions used to encode "." and "_". Not sure which version is actually required though (fixed in 7.26.0 but broken in 7.19.7, we're testing for 7.26.0)
-    if (LIBCURL_VERSION_NUM >= 0x071a00) {
-        QTest::newRow("1") << "email_1@email.com" << "John Doe" << "mailto:John%20Doe%3Cemail_1%40email.com%3E";
-        QTest::newRow("Reserved characters") << "!*'();:@&=+$,/?#[]@email.com" << "John Doe" << "mailto:John%20Doe%3C%21%2A%27%28%29%3B%3A%40%26%3D%2B%24%2C%2F%3F%23%5B%5D%40email.com%3E";
-        QTest::newRow("Unreserved characters") << "Aa0-_.~@email.com" << "John Doe" << "mailto:John%20Doe%3CAa0-_.~%40email.com%3E";
-    } else {
-        QTest::newRow("1") << "email_1@email.com" << "John Doe" << "mailto:John%20Doe%3Cemail%5F1%40email%2Ecom%3E";
-        QTest::newRow("Reserved characters") << "!*'();:@&=+$,/?#[]@email.com" << "John Doe" << "mailto:John%20Doe%3C%21%2A%27%28%29%3B%3A%40%26%3D%2B%24%2C%2F%3F%23%5B%5D%40email%2Ecom%3E";
-        QTest::newRow("Unreserved characters") << "Aa0-_.~@email.com" << "John Doe" << "mailto:John%20Doe%3CAa0%2D%5F%2E%7E%40email%2Ecom%3E";
-    }
+    QTest::newRow("1") << "email_1@email.com" << "John Doe" << "mailto:John%20Doe%3Cemail_1%40email.com%3E";
+    QTest::newRow("Reserved characters") << "!*'();:@&=+$,/?#[]@email.com" << "John Doe" << "mailto:John%20Doe%3C%21%2A%27%28%29%3B%3A%40%26%3D%2B%24%2C%2F%3F%23%5B%5D%40email.com%3E";
+    QTest::newRow("Unreserved characters") << "Aa0-_.~@email.com" << "John Doe" << "mailto:John%20Doe%3CAa0-_.~%40email.com%3E";
+    QTest::newRow("No name") << "email@email.com" << "" << "mailto:%3Cemail%40email.com%3E";
     
     Kolab::Utils::clearErrors();
 }
@@ -217,6 +383,49 @@ void ConversionTest::mailtoUriDecodingTest()
     QCOMPARE(QString::fromStdString(e), email);
 }
 
+template <typename T, std::size_t N>
+void checkEnumStrings(const Kolab::Shared::EnumString<T> (&table)[N])
+{
+    for (std::size_t i = 0; i < N; i++) {
+        const std::string s = Kolab::Shared::enumToString(table, table[i].value);
+        QCOMPARE(s.size(), table[i].length);
+        T value;
+        QVERIFY(Kolab::Shared::enumFromString(table, table[i].string, value));
+        QCOMPARE(value, table[i].value);
+    }
+    T value = table[0].value;
+    QVERIFY(!Kolab::Shared::enumFromString(table, "", value));
+    QVERIFY(!Kolab::Shared::enumFromString(table, std::string(table[0].string) + "X", value));
+    QCOMPARE(value, table[0].value);
+}
+
+void ConversionTest::enumStringTest()
+{
+    checkEnumStrings(Kolab::XCAL::statusStrings);
+    checkEnumStrings(Kolab::XCAL::classificationStrings);
+    checkEnumStrings(Kolab::XCAL::partStatStrings);
+    checkEnumStrings(Kolab::XCAL::roleStrings);
+    checkEnumStrings(Kolab::XCAL::cutypeStrings);
+    checkEnumStrings(Kolab::XCAL::weekdayStrings);
+    checkEnumStrings(Kolab::XCAL::fbtypeStrings);
+    checkEnumStrings(Kolab::XCARD::relatedTypeStrings);
+    checkEnumStrings(Kolab::XCARD::homeWorkTypeStrings);
+    checkEnumStrings(Kolab::XCARD::telephoneTypeStrings);
+
+    //Legacy spellings are understood but not written
+    Kolab::Status status = Kolab::StatusUndefined;
+    QVERIFY(Kolab::Shared::enumFromString(Kolab::XCAL::statusStrings, "OPAQUE", status));
+    QCOMPARE(status, Kolab::StatusCompleted);
+    QCOMPARE(std::string(Kolab::Shared::enumToString(Kolab::XCAL::statusStrings, Kolab::StatusCompleted)), std::string("COMPLETED"));
+
+    std::vector<std::string> types;
+    Kolab::Shared::flagsToStrings(Kolab::XCARD::telephoneTypeStrings, Kolab::Telephone::Work | Kolab::Telephone::Car, types);
+    QCOMPARE(types, std::vector<std::string>() << std::string("x-car") << std::string("work"));
+    types.push_back("unknown");
+    QCOMPARE(Kolab::Shared::flagsFromStrings(Kolab::XCARD::telephoneTypeStrings, types), static_cast<int>(Kolab::Telephone::Work | Kolab::Telephone::Car));
+    QCOMPARE(Kolab::Utils::getError(), Kolab::NoError);
+}
+
 void ConversionTest::urnTest()
 {
     QCOMPARE(Kolab::Shared::toURN("1045b57d-ff7f-0000-d814-867b4d7f0000"), std::string("urn:uuid:1045b57d-ff7f-0000-d814-867b4d7f0000"));
@@ -251,6 +460,29 @@ void ConversionTest::contactReferenceTest()
     
     QCOMPARE(Kolab::Shared::toContactReference("urn:uuid:urn"), urn);
     QCOMPARE(Kolab::Shared::toContactReference("mailto:name%3Cmail%3E"), email);
+    QCOMPARE(Kolab::Utils::getError(), Kolab::NoError);
+
+    //Malformed references are returned as they are
+    std::string name("unchanged");
+    QCOMPARE(Kolab::Utils::fromMailto("mailto:mail", name), std::string("mailto:mail"));
+    QCOMPARE(Kolab::Utils::fromMailto("mailto:name%3Cmail", name), std::string("mailto:name%3Cmail"));
+    QCOMPARE(Kolab::Utils::fromMailto("name%3Cmail%3E", name), std::string("name%3Cmail%3E"));
+    QCOMPARE(name, std::string("unchanged"));
+    QCOMPARE(Kolab::Utils::getError(), Kolab::Warning);
+    Kolab::Utils::clearErrors();
+
+    //Memoized references decode identically
+    {
+        Kolab::Utils::MailtoCacheScope cache;
+        for (int i = 0; i < 3; i++) {
+            QCOMPARE(Kolab::Shared::toContactReference("mailto:name%3Cmail%3E"), email);
+            QCOMPARE(Kolab::Utils::fromMailto("mailto:%3Cmail%3E", name), std::string("mail"));
+            QCOMPARE(name, std::string());
+            QCOMPARE(Kolab::Utils::fromMailto("mailto:mail", name), std::string("mailto:mail"));
+            QCOMPARE(Kolab::Utils::getError(), Kolab::Warning);
+            Kolab::Utils::clearErrors();
+        }
+    }
 }
 
 
@@ -277,6 +509,56 @@ void ConversionTest::threadLocalTest()
     t2.join();
 }
 
+static std::vector<std::pair<Kolab::ErrorSeverity, std::string> > loggedMessages;
+
+static void recordingLogHandler(Kolab::ErrorSeverity severity, const std::string &message)
+{
+    loggedMessages.push_back(std::make_pair(severity, message));
+}
+
+void ConversionTest::logHandlerTest()
+{
+    using namespace Kolab;
+    loggedMessages.clear();
+    Utils::clearErrors();
+    Utils::setLogHandler(&recordingLogHandler);
+
+    WARNING("warning");
+    QCOMPARE(loggedMessages.size(), std::size_t(1));
+    QCOMPARE(loggedMessages.front().first, Kolab::Warning);
+    QVERIFY(loggedMessages.front().second.find("warning") != std::string::npos);
+    QCOMPARE(Utils::getError(), Kolab::Warning);
+
+    //Below the threshold nothing reaches the handler, but the error state is still maintained
+    loggedMessages.clear();
+    Utils::clearErrors();
+    Utils::setLogThreshold(Kolab::Critical);
+    QVERIFY(!Utils::isLogged(Kolab::NoError));
+    LOG("debug")
+    ERROR("error");
+    QVERIFY(loggedMessages.empty());
+    QCOMPARE(Utils::getError(), Kolab::Error);
+    QVERIFY(Utils::getErrorMessage().find("error") != std::string::npos);
+    CRITICAL("critical");
+    QCOMPARE(loggedMessages.size(), std::size_t(1));
+    QCOMPARE(Utils::getError(), Kolab::Critical);
+    //Debug messages are not recorded
+    QCOMPARE(Utils::getDiagnostics().size(), std::size_t(2));
+
+    //Without handler
+    loggedMessages.clear();
+    Utils::clearErrors();
+    Utils::setLogThreshold(Kolab::NoError);
+    Utils::setLogHandler(0);
+    QVERIFY(!Utils::isLogged(Kolab::NoError));
+    ERROR("error");
+    QVERIFY(loggedMessages.empty());
+    QCOMPARE(Utils::getError(), Kolab::Error);
+
+    Utils::setLogHandler(&Utils::defaultLogHandler);
+    Utils::clearErrors();
+}
+
 void ConversionTest::uuidGeneratorTest()
 {
     const std::string &s = getUID();
@@ -302,9 +584,45 @@ void ConversionTest::uuidGeneratorTest2()
     QVERIFY(!uid2.empty());
     QVERIFY(uid1 != uid2);
 }
+void ConversionTest::uuidGeneratorBatchTest()
+{
+    const std::vector<std::string> &uids = Kolab::generateUIDs(1000);
+    QCOMPARE(uids.size(), (std::size_t)1000ul);
+    std::set<std::string> unique(uids.begin(), uids.end());
+    unique.insert(Kolab::generateUID());
+    QCOMPARE(unique.size(), (std::size_t)1001ul);
+    BOOST_FOREACH(const std::string &uid, uids) {
+        QCOMPARE(uid.size(), (std::size_t)36ul);
+    }
+    QVERIFY(Kolab::generateUIDs(0).empty());
+    QVERIFY(Kolab::generateUIDs(-1).empty());
+}
 
+void generateUIDs(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        Kolab::generateUID();
+    }
+}
 
+void ConversionTest::uuidGeneratorBenchmark_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("4 threads") << 4;
+}
 
+void ConversionTest::uuidGeneratorBenchmark()
+{
+    QFETCH(int, threads);
+    QBENCHMARK {
+        boost::thread_group group;
+        for (int i = 0; i < threads; i++) {
+            group.create_thread(boost::bind(generateUIDs, 10000));
+        }
+        group.join_all();
+    }
+}
 
 QTEST_MAIN( ConversionTest )
 
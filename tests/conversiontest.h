@@ -16,6 +16,12 @@ class ConversionTest : public QObject
     void durationSerializerTest_data();
     void durationSerializerTest();
     
+    void durationParserErrorTest_data();
+    void durationParserErrorTest();
+    void durationRoundtripTest();
+    void numericStringTest();
+    void durationBenchmark();
+    
     void dayPosParserTest_data();
     void dayPosParserTest();
     
@@ -30,20 +36,31 @@ class ConversionTest : public QObject
     
     void uriInlineEncodingTest();
     
+    void uriEncodingTest_data();
+    void uriEncodingTest();
+    void uriDecodingTest();
+    
     void mailtoUriEncodingTest_data();
     void mailtoUriEncodingTest();
     void mailtoUriDecodingTest();
     
     void urnTest();
     
+    void enumStringTest();
+    
     void contactReferenceTest();
     
     void geoUriTest();
     
     void threadLocalTest();
     
+    void logHandlerTest();
+    
     void uuidGeneratorTest();
     void uuidGeneratorTest2();
+    void uuidGeneratorBatchTest();
+    void uuidGeneratorBenchmark_data();
+    void uuidGeneratorBenchmark();
 };
 
 #endif // CONVERSIONTEST_H
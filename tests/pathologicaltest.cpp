@@ -0,0 +1,194 @@
+/*
+    Copyright (C) 2012 Christian Mollekopf <mollekopf@kolabsys.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "pathologicaltest.h"
+
+#include <QtTest/QtTest>
+#include <src/kolabformat.h>
+#include "testobjects.h"
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <algorithm>
+#include <cstdlib>
+
+enum Kind {
+    ExceptionsKind,
+    FreebusyKind,
+    DistlistKind,
+    WideCategoriesKind,
+    DeepCategoriesKind,
+    DescriptionKind
+};
+
+//The larger object is this many times the size of the smaller one
+static const int factor = 4;
+//Allowed memory of the larger object relative to the smaller one (linear would be factor)
+static const double maxRatio = 2.0 * factor;
+//Absolute slack, so noise on small timings doesn't fail the opt-in time check
+static const double timeSlack = 0.05;
+static const unsigned long memorySlack = 1024 * 1024;
+
+//Absolute ceilings
+static const unsigned long maxTime = 60 * 1000;
+static const unsigned long memoryBudget = 1024ul * 1024ul * 1024ul;
+
+struct Cost {
+    Cost(): seconds(0), peakBytes(0) {}
+    double seconds;
+    unsigned long peakBytes;
+};
+
+static std::vector<Kolab::CategoryColor> createCategories(int width, int depth)
+{
+    std::vector<Kolab::CategoryColor> list;
+    list.reserve(static_cast<std::size_t>(width));
+    for (int i = 0; i < width; i++) {
+        Kolab::CategoryColor color(QString("category%1").arg(i).toStdString());
+        color.setColor("#FF0000");
+        if (depth > 1) {
+            color.setSubcategories(createCategories(1, depth - 1));
+        }
+        list.push_back(color);
+    }
+    return list;
+}
+
+static Kolab::Configuration createCategoryConfiguration(int width, int depth)
+{
+    Kolab::Configuration configuration(createCategories(width, depth));
+    configuration.setUid("uid");
+    configuration.setCreated(Kolab::cDateTime(2006,1,6,12,0,0,true)); //UTC
+    configuration.setLastModified(Kolab::cDateTime(2006,1,6,12,0,0,true)); //UTC
+    return configuration;
+}
+
+static Kolab::Event createDescriptionEvent(int size)
+{
+    Kolab::Event event = createEvent(0, false);
+    event.setDescription(std::string(static_cast<std::size_t>(size), 'a'));
+    return event;
+}
+
+static double now()
+{
+    return static_cast<double>((boost::posix_time::microsec_clock::universal_time() - boost::posix_time::ptime(boost::gregorian::date(1970,1,1))).total_microseconds()) / 1000000.0;
+}
+
+/*
+ * Cost of writing and reading the object (the faster of two runs).
+ */
+template <typename T>
+static bool measure(const T &object, Cost &cost)
+{
+    cost = Cost();
+    for (int run = 0; run < 2; run++) {
+        const double start = now();
+        const std::string serialized = write(object);
+        if (Kolab::error() != Kolab::NoError) {
+            return false;
+        }
+        unsigned long peakBytes = Kolab::lastOperationMemory().peakBytes;
+        read(serialized, &object);
+        if (Kolab::error() != Kolab::NoError) {
+            return false;
+        }
+        peakBytes = std::max(peakBytes, Kolab::lastOperationMemory().peakBytes);
+        const double seconds = now() - start;
+        if (!run || seconds < cost.seconds) {
+            cost.seconds = seconds;
+        }
+        cost.peakBytes = std::max(cost.peakBytes, peakBytes);
+    }
+    return true;
+}
+
+static bool measure(Kind kind, int size, Cost &cost)
+{
+    switch (kind) {
+        case ExceptionsKind:
+            return measure(createEvent(size, true), cost);
+        case FreebusyKind:
+            return measure(createFreebusy(size), cost);
+        case DistlistKind:
+            return measure(createDistlist(size), cost);
+        case WideCategoriesKind:
+            return measure(createCategoryConfiguration(size, 3), cost);
+        case DeepCategoriesKind:
+            return measure(createCategoryConfiguration(1, size), cost);
+        case DescriptionKind:
+            return measure(createDescriptionEvent(size), cost);
+    }
+    return false;
+}
+
+void PathologicalTest::initTestCase()
+{
+    Kolab::ResourceLimits limits;
+    limits.maxTime = maxTime;
+    Kolab::setResourceLimits(limits);
+    Kolab::setMemoryBudget(memoryBudget);
+    //The peak bytes are checked for every object
+    Kolab::setMemoryAccountingEnabled(true);
+}
+
+void PathologicalTest::cleanupTestCase()
+{
+    Kolab::setResourceLimits(Kolab::ResourceLimits());
+    Kolab::setMemoryBudget(0);
+    Kolab::setMemoryAccountingEnabled(false);
+}
+
+void PathologicalTest::linearityTest_data()
+{
+    QTest::addColumn<int>("kind");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("linear");
+
+    QTest::newRow("10k exceptions") << static_cast<int>(ExceptionsKind) << 10000 << true;
+    QTest::newRow("100k freebusy periods") << static_cast<int>(FreebusyKind) << 100000 << true;
+    QTest::newRow("50k distlist members") << static_cast<int>(DistlistKind) << 50000 << true;
+    QTest::newRow("10k categories") << static_cast<int>(WideCategoriesKind) << 10000 << true;
+    //CategoryColor hands out its subcategories by value, so each level copies its subtree: only the ceilings apply
+    QTest::newRow("200 nested categories") << static_cast<int>(DeepCategoriesKind) << 200 << false;
+    QTest::newRow("10M description") << static_cast<int>(DescriptionKind) << 10 * 1024 * 1024 << true;
+}
+
+void PathologicalTest::linearityTest()
+{
+    QFETCH(int, kind);
+    QFETCH(int, size);
+    QFETCH(bool, linear);
+
+    Cost small;
+    QVERIFY(measure(static_cast<Kind>(kind), size / factor, small));
+    Cost large;
+    QVERIFY(measure(static_cast<Kind>(kind), size, large));
+    qDebug() << "seconds:" << small.seconds << large.seconds << "peak bytes:" << small.peakBytes << large.peakBytes;
+
+    if (!linear) {
+        return;
+    }
+    const char *maxTimeRatio = getenv("KOLAB_MAX_TIME_RATIO");
+    if (maxTimeRatio) {
+        QVERIFY2(large.seconds <= small.seconds * atof(maxTimeRatio) + timeSlack, QString("%1s for %2, %3s for %4").arg(large.seconds).arg(size).arg(small.seconds).arg(size / factor).toLatin1().constData());
+    }
+    QVERIFY2(large.peakBytes <= static_cast<unsigned long>(static_cast<double>(small.peakBytes) * maxRatio) + memorySlack, QString("%1 bytes for %2, %3 bytes for %4").arg(large.peakBytes).arg(size).arg(small.peakBytes).arg(size / factor).toLatin1().constData());
+}
+
+QTEST_MAIN( PathologicalTest )
+
+#include "pathologicaltest.moc"
@@ -0,0 +1,44 @@
+/*
+    Copyright (C) 2012 Christian Mollekopf <mollekopf@kolabsys.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef PATHOLOGICALTEST_H
+#define PATHOLOGICALTEST_H
+
+#include <QObject>
+
+/*
+ * Worst-case inputs (thousands of exceptions, freebusy periods and distlist members, deep category trees, huge texts).
+ *
+ * Every object is read and written in two sizes, and the larger one (four times the size) must not take more than
+ * twice the proportional memory, so paths which turn super-linear are caught independently of the machine.
+ * Timings are too noisy on loaded machines to fail by default: if KOLAB_MAX_TIME_RATIO is set (i.e. to 8), the test fails
+ * if the larger object takes more than that many times as long as the smaller one.
+ * The absolute time and memory ceilings are enforced through the resource limits and the memory budget.
+ */
+class PathologicalTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void linearityTest_data();
+    void linearityTest();
+};
+
+#endif
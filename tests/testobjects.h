@@ -0,0 +1,210 @@
+/*
+    Copyright (C) 2012 Christian Mollekopf <mollekopf@kolabsys.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef TESTOBJECTS_H
+#define TESTOBJECTS_H
+
+/*
+ * Canonical objects of every type (in configurable sizes), and overloads to read and write them generically.
+ */
+
+#include <string>
+#include <vector>
+#include <src/kolabformat.h>
+#include <boost/date_time/gregorian/gregorian_types.hpp>
+
+inline Kolab::Attachment createAttachment(int size)
+{
+    Kolab::Attachment attachment;
+    attachment.setData(std::string(size, 'a'), "application/octet-stream");
+    attachment.setLabel("label");
+    return attachment;
+}
+
+template <typename T>
+inline void setIncidence(T &incidence)
+{
+    incidence.setUid("uid");
+    incidence.setCreated(Kolab::cDateTime(2006,1,6,12,0,0,true)); //UTC
+    incidence.setLastModified(Kolab::cDateTime(2006,1,6,12,0,0,true)); //UTC
+    incidence.setSummary("summary");
+    incidence.setDescription(std::string(500, 'd'));
+    incidence.setStart(Kolab::cDateTime("Europe/Zurich", 2006,1,6,12,0,0));
+    incidence.setOrganizer(Kolab::ContactReference("organizer@example.org", "organizer"));
+    std::vector<Kolab::Attendee> attendees;
+    for (int i = 0; i < 5; i++) {
+        attendees.push_back(Kolab::Attendee(Kolab::ContactReference("attendee@example.org", "attendee")));
+    }
+    incidence.setAttendees(attendees);
+}
+
+inline Kolab::Event createEvent(int exceptions, bool recurring)
+{
+    Kolab::Event event;
+    setIncidence(event);
+    event.setEnd(Kolab::cDateTime("Europe/Zurich", 2006,1,6,14,0,0));
+    if (recurring || exceptions) {
+        Kolab::RecurrenceRule rrule;
+        rrule.setFrequency(Kolab::RecurrenceRule::Daily);
+        rrule.setCount(exceptions + 10);
+        event.setRecurrenceRule(rrule);
+    }
+    std::vector<Kolab::Event> list;
+    list.reserve(static_cast<std::size_t>(exceptions));
+    for (int i = 0; i < exceptions; i++) {
+        //One exception per occurrence, starting with the day after the first one
+        const boost::gregorian::date day = boost::gregorian::date(2006, 1, 7) + boost::gregorian::days(i);
+        Kolab::Event exception;
+        setIncidence(exception);
+        exception.setStart(Kolab::cDateTime("Europe/Zurich", day.year(), day.month(), day.day(), 13, 0, 0));
+        exception.setRecurrenceID(Kolab::cDateTime("Europe/Zurich", day.year(), day.month(), day.day(), 12, 0, 0), false);
+        list.push_back(exception);
+    }
+    event.setExceptions(list);
+    return event;
+}
+
+inline Kolab::Todo createTodo()
+{
+    Kolab::Todo todo;
+    setIncidence(todo);
+    todo.setDue(Kolab::cDateTime("Europe/Zurich", 2006,1,8,12,0,0));
+    return todo;
+}
+
+inline Kolab::Journal createJournal()
+{
+    Kolab::Journal journal;
+    journal.setUid("uid");
+    journal.setCreated(Kolab::cDateTime(2006,1,6,12,0,0,true)); //UTC
+    journal.setLastModified(Kolab::cDateTime(2006,1,6,12,0,0,true)); //UTC
+    journal.setSummary("summary");
+    journal.setDescription(std::string(500, 'd'));
+    journal.setStart(Kolab::cDateTime("Europe/Zurich", 2006,1,6,12,0,0));
+    return journal;
+}
+
+inline Kolab::Freebusy createFreebusy(int periods)
+{
+    Kolab::Freebusy freebusy;
+    freebusy.setUid("uid");
+    freebusy.setTimestamp(Kolab::cDateTime(2006,1,6,12,0,0,true));
+    freebusy.setStart(Kolab::cDateTime(2006,1,6,12,0,0,true));
+    freebusy.setEnd(Kolab::cDateTime(2007,1,6,12,0,0,true));
+    freebusy.setOrganizer(Kolab::ContactReference(Kolab::ContactReference::EmailReference, "organizer@example.org", "organizer"));
+    std::vector<Kolab::FreebusyPeriod> list;
+    for (int i = 0; i < periods; i++) {
+        Kolab::FreebusyPeriod period;
+        period.setType(Kolab::FreebusyPeriod::Busy);
+        period.setEvent("uid", "summary", "location");
+        period.setPeriods(std::vector<Kolab::Period>() << Kolab::Period(Kolab::cDateTime(2006,1,6,12,0,0,true), Kolab::cDateTime(2006,1,6,13,0,0,true)));
+        list.push_back(period);
+    }
+    freebusy.setPeriods(list);
+    return freebusy;
+}
+
+inline Kolab::Contact createContact(int photoSize)
+{
+    Kolab::Contact contact;
+    contact.setUid("1045b57d-ff7f-0000-d814-867b4d7f0000");
+    contact.setLastModified(Kolab::cDateTime(2006,1,6,12,0,0,true));
+    contact.setName("name");
+    Kolab::NameComponents nc;
+    nc.setSurnames(std::vector<std::string>(1, "surname"));
+    nc.setGiven(std::vector<std::string>(1, "given"));
+    contact.setNameComponents(nc);
+    contact.setNote("note");
+    contact.setEmailAddresses(std::vector<Kolab::Email>() << Kolab::Email("mail@example.org") << Kolab::Email("other@example.org"), 0);
+    if (photoSize) {
+        contact.setPhoto(std::string(photoSize, 'p'), "image/jpeg");
+    }
+    return contact;
+}
+
+inline Kolab::DistList createDistlist(int members)
+{
+    Kolab::DistList distlist;
+    distlist.setUid("uid");
+    distlist.setName("name");
+    std::vector<Kolab::ContactReference> list;
+    for (int i = 0; i < members; i++) {
+        list.push_back(Kolab::ContactReference(Kolab::ContactReference::EmailReference, "member@example.org", "member"));
+    }
+    distlist.setMembers(list);
+    return distlist;
+}
+
+inline Kolab::Note createNote()
+{
+    Kolab::Note note;
+    note.setUid("uid");
+    note.setCreated(Kolab::cDateTime(2006,1,6,12,0,0,true)); //UTC
+    note.setLastModified(Kolab::cDateTime(2006,1,6,12,0,0,true)); //UTC
+    note.setSummary("summary");
+    note.setDescription(std::string(2000, 'd'));
+    return note;
+}
+
+inline Kolab::Configuration createConfiguration(int entries)
+{
+    Kolab::Dictionary dictionary("en");
+    std::vector<std::string> list;
+    for (int i = 0; i < entries; i++) {
+        list.push_back("entry");
+    }
+    dictionary.setEntries(list);
+    Kolab::Configuration configuration(dictionary);
+    configuration.setUid("uid");
+    configuration.setCreated(Kolab::cDateTime(2006,1,6,12,0,0,true)); //UTC
+    configuration.setLastModified(Kolab::cDateTime(2006,1,6,12,0,0,true)); //UTC
+    return configuration;
+}
+
+inline Kolab::File createFile(int size)
+{
+    Kolab::File file;
+    file.setUid("uid");
+    file.setCreated(Kolab::cDateTime(2006,1,6,12,0,0,true)); //UTC
+    file.setLastModified(Kolab::cDateTime(2006,1,6,12,0,0,true)); //UTC
+    file.setNote("note");
+    file.setFile(createAttachment(size));
+    return file;
+}
+
+inline std::string write(const Kolab::Event &o) { return Kolab::writeEvent(o); }
+inline std::string write(const Kolab::Todo &o) { return Kolab::writeTodo(o); }
+inline std::string write(const Kolab::Journal &o) { return Kolab::writeJournal(o); }
+inline std::string write(const Kolab::Freebusy &o) { return Kolab::writeFreebusy(o); }
+inline std::string write(const Kolab::Contact &o) { return Kolab::writeContact(o); }
+inline std::string write(const Kolab::DistList &o) { return Kolab::writeDistlist(o); }
+inline std::string write(const Kolab::Note &o) { return Kolab::writeNote(o); }
+inline std::string write(const Kolab::Configuration &o) { return Kolab::writeConfiguration(o); }
+inline std::string write(const Kolab::File &o) { return Kolab::writeFile(o); }
+
+inline void read(const std::string &s, const Kolab::Event *) { Kolab::readEvent(s, false); }
+inline void read(const std::string &s, const Kolab::Todo *) { Kolab::readTodo(s, false); }
+inline void read(const std::string &s, const Kolab::Journal *) { Kolab::readJournal(s, false); }
+inline void read(const std::string &s, const Kolab::Freebusy *) { Kolab::readFreebusy(s, false); }
+inline void read(const std::string &s, const Kolab::Contact *) { Kolab::readContact(s, false); }
+inline void read(const std::string &s, const Kolab::DistList *) { Kolab::readDistlist(s, false); }
+inline void read(const std::string &s, const Kolab::Note *) { Kolab::readNote(s, false); }
+inline void read(const std::string &s, const Kolab::Configuration *) { Kolab::readConfiguration(s, false); }
+inline void read(const std::string &s, const Kolab::File *) { Kolab::readFile(s, false); }
+
+#endif
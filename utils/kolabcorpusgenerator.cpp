@@ -0,0 +1,442 @@
+/*
+ * Copyright (C) 2011  Christian Mollekopf <mollekopf@kolabsys.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Generates corpora of valid Kolab v3 objects for benchmarks and capacity tests.
+ *
+ * The output only depends on the seed and the options, so a corpus can be regenerated instead of being stored.
+ * The sizes are uniformly distributed within the given ranges ("min:max", or a single value).
+ */
+
+#include <boost/program_options.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "src/kolabformat.h"
+
+namespace po = boost::program_options;
+using namespace std;
+
+struct Range {
+    Range(int mi = 0, int ma = 0): min(mi), max(ma) {};
+    int min;
+    int max;
+};
+
+static bool parseRange(const string &s, Range &range)
+{
+    char *end;
+    const long min = strtol(s.c_str(), &end, 10);
+    long max = min;
+    if (*end == ':') {
+        max = strtol(end + 1, &end, 10);
+    }
+    if (*end || end == s.c_str() || min < 0 || max < min || max > 100000000) {
+        cerr << "Invalid range: " << s << endl;
+        return false;
+    }
+    range = Range(static_cast<int>(min), static_cast<int>(max));
+    return true;
+}
+
+class Generator {
+public:
+    Generator(unsigned int seed): mSeed(seed), mRandom(seed), mCount(0) {};
+
+    Range attendees;
+    Range exceptions;
+    Range recurrence;
+    Range photoSize;
+    Range members;
+    Range relationMembers;
+    Range attachmentSize;
+
+    /**
+     * Returns the next object of the given type ("event", "todo", ...) serialized, or an empty string on an error.
+     */
+    string next(const string &type)
+    {
+        mCount++;
+        if (type == "event") {
+            return Kolab::writeEvent(event(uid()));
+        } else if (type == "todo") {
+            return Kolab::writeTodo(todo());
+        } else if (type == "journal") {
+            return Kolab::writeJournal(journal());
+        } else if (type == "freebusy") {
+            return Kolab::writeFreebusy(freebusy());
+        } else if (type == "contact") {
+            return Kolab::writeContact(contact());
+        } else if (type == "distlist") {
+            return Kolab::writeDistlist(distlist());
+        } else if (type == "note") {
+            return Kolab::writeNote(note());
+        } else if (type == "configuration") {
+            return Kolab::writeConfiguration(configuration());
+        } else if (type == "file") {
+            return Kolab::writeFile(file());
+        }
+        cerr << "Unknown type: " << type << endl;
+        return string();
+    }
+
+    int random(const Range &range)
+    {
+        return boost::random::uniform_int_distribution<int>(range.min, range.max)(mRandom);
+    }
+
+private:
+    string uid()
+    {
+        ostringstream s;
+        s << "corpus-" << mSeed << "-" << mCount;
+        return s.str();
+    }
+
+    string text(int length)
+    {
+        static const char words[] = "lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod tempor ";
+        string s;
+        s.reserve(static_cast<size_t>(length));
+        for (int i = 0; i < length; i++) {
+            s.push_back(words[random(Range(0, sizeof(words) - 2))]);
+        }
+        return s;
+    }
+
+    Kolab::cDateTime date(int dayOffset = 0)
+    {
+        //A day in 2013, the times are in full hours
+        const int day = random(Range(0, 364)) + dayOffset;
+        return Kolab::cDateTime("Europe/Zurich", 2013 + day / 365, 1 + (day % 365) / 31 % 12, 1 + day % 28, random(Range(7, 18)), 0, 0);
+    }
+
+    Kolab::ContactReference person(const char *role)
+    {
+        ostringstream email;
+        email << role << random(Range(0, 10000)) << "@example.org";
+        return Kolab::ContactReference(email.str(), text(12));
+    }
+
+    Kolab::RecurrenceRule rrule(int complexity)
+    {
+        Kolab::RecurrenceRule rule;
+        switch (complexity) {
+            case 1:
+                rule.setFrequency(random(Range(0, 1)) ? Kolab::RecurrenceRule::Daily : Kolab::RecurrenceRule::Weekly);
+                rule.setCount(random(Range(2, 50)));
+                break;
+            case 2: {
+                rule.setFrequency(Kolab::RecurrenceRule::Weekly);
+                rule.setInterval(random(Range(1, 4)));
+                std::vector<Kolab::DayPos> days;
+                for (int day = Kolab::Monday; day <= Kolab::Friday; day++) {
+                    if (random(Range(0, 1))) {
+                        days.push_back(Kolab::DayPos(0, static_cast<Kolab::Weekday>(day)));
+                    }
+                }
+                if (days.empty()) {
+                    days.push_back(Kolab::DayPos(0, Kolab::Wednesday));
+                }
+                rule.setByday(days);
+                rule.setEnd(Kolab::cDateTime(2015, 1, 1, 0, 0, 0, true));
+                break;
+            }
+            default: {
+                rule.setFrequency(Kolab::RecurrenceRule::Monthly);
+                rule.setByday(std::vector<Kolab::DayPos>(1, Kolab::DayPos(random(Range(1, 4)), static_cast<Kolab::Weekday>(random(Range(0, 6))))));
+                std::vector<int> months;
+                for (int month = 1; month <= 12; month += random(Range(1, 3))) {
+                    months.push_back(month);
+                }
+                rule.setBymonth(months);
+                rule.setCount(random(Range(5, 100)));
+            }
+        }
+        return rule;
+    }
+
+    template <typename T>
+    void incidence(T &inc, const string &uid)
+    {
+        inc.setUid(uid);
+        inc.setCreated(Kolab::cDateTime(2013, 1, 1, 12, 0, 0, true));
+        inc.setLastModified(Kolab::cDateTime(2013, 1, 2, 12, 0, 0, true));
+        inc.setSequence(random(Range(0, 5)));
+        inc.setSummary(text(random(Range(10, 60))));
+        inc.setDescription(text(random(Range(0, 2000))));
+        inc.setStart(date());
+        const int count = random(attendees);
+        if (count) {
+            inc.setOrganizer(person("organizer"));
+            std::vector<Kolab::Attendee> list;
+            list.reserve(static_cast<size_t>(count));
+            for (int i = 0; i < count; i++) {
+                Kolab::Attendee attendee(person("attendee"));
+                attendee.setPartStat(static_cast<Kolab::PartStatus>(random(Range(Kolab::PartNeedsAction, Kolab::PartTentative))));
+                attendee.setRSVP(random(Range(0, 1)));
+                list.push_back(attendee);
+            }
+            inc.setAttendees(list);
+        }
+    }
+
+    template <typename T>
+    void recurring(T &inc)
+    {
+        int complexity = random(recurrence);
+        const int count = random(exceptions);
+        if (count && !complexity) {
+            //Exceptions need a recurrence
+            complexity = 1;
+        }
+        if (!complexity) {
+            return;
+        }
+        inc.setRecurrenceRule(rrule(complexity));
+        if (complexity > 2) {
+            inc.addExceptionDate(date(1));
+            inc.addRecurrenceDate(date(2));
+        }
+        std::vector<T> list;
+        list.reserve(static_cast<size_t>(count));
+        for (int i = 0; i < count; i++) {
+            T exception;
+            incidence(exception, inc.uid());
+            exception.setRecurrenceID(date(i + 1), false);
+            list.push_back(exception);
+        }
+        inc.setExceptions(list);
+    }
+
+    Kolab::Event event(const string &uid)
+    {
+        Kolab::Event event;
+        incidence(event, uid);
+        event.setLocation(text(20));
+        recurring(event);
+        return event;
+    }
+
+    Kolab::Todo todo()
+    {
+        Kolab::Todo todo;
+        incidence(todo, uid());
+        todo.setDue(date(30));
+        todo.setPercentComplete(random(Range(0, 100)));
+        recurring(todo);
+        return todo;
+    }
+
+    Kolab::Journal journal()
+    {
+        Kolab::Journal journal;
+        journal.setUid(uid());
+        journal.setCreated(Kolab::cDateTime(2013, 1, 1, 12, 0, 0, true));
+        journal.setLastModified(Kolab::cDateTime(2013, 1, 2, 12, 0, 0, true));
+        journal.setSummary(text(40));
+        journal.setDescription(text(random(Range(100, 5000))));
+        journal.setStart(date());
+        return journal;
+    }
+
+    Kolab::Freebusy freebusy()
+    {
+        Kolab::Freebusy freebusy;
+        freebusy.setUid(uid());
+        freebusy.setTimestamp(Kolab::cDateTime(2013, 1, 1, 12, 0, 0, true));
+        freebusy.setStart(Kolab::cDateTime(2013, 1, 1, 0, 0, 0, true));
+        freebusy.setEnd(Kolab::cDateTime(2014, 1, 1, 0, 0, 0, true));
+        freebusy.setOrganizer(person("organizer"));
+        //A period per attendee of the busy events
+        const int count = random(attendees) + 1;
+        std::vector<Kolab::FreebusyPeriod> list;
+        for (int i = 0; i < count; i++) {
+            Kolab::FreebusyPeriod period;
+            period.setType(static_cast<Kolab::FreebusyPeriod::FBType>(random(Range(Kolab::FreebusyPeriod::Busy, Kolab::FreebusyPeriod::OutOfOffice))));
+            period.setEvent(uid(), text(20), text(10));
+            const int day = random(Range(1, 28));
+            period.setPeriods(std::vector<Kolab::Period>(1, Kolab::Period(Kolab::cDateTime(2013, 1 + i % 12, day, 8, 0, 0, true), Kolab::cDateTime(2013, 1 + i % 12, day, 17, 0, 0, true))));
+            list.push_back(period);
+        }
+        freebusy.setPeriods(list);
+        return freebusy;
+    }
+
+    Kolab::Contact contact()
+    {
+        Kolab::Contact contact;
+        contact.setUid(uid());
+        contact.setLastModified(Kolab::cDateTime(2013, 1, 2, 12, 0, 0, true));
+        contact.setName(text(20));
+        Kolab::NameComponents nc;
+        nc.setGiven(std::vector<std::string>(1, text(8)));
+        nc.setSurnames(std::vector<std::string>(1, text(10)));
+        contact.setNameComponents(nc);
+        contact.setNote(text(random(Range(0, 500))));
+        std::vector<Kolab::Email> emails;
+        for (int i = random(Range(1, 3)); i > 0; i--) {
+            emails.push_back(Kolab::Email(person("contact").email()));
+        }
+        contact.setEmailAddresses(emails, 0);
+        const int size = random(photoSize);
+        if (size) {
+            contact.setPhoto(text(size), "image/jpeg");
+        }
+        return contact;
+    }
+
+    Kolab::DistList distlist()
+    {
+        Kolab::DistList distlist;
+        distlist.setUid(uid());
+        distlist.setName(text(20));
+        const int count = random(members);
+        std::vector<Kolab::ContactReference> list;
+        list.reserve(static_cast<size_t>(count));
+        for (int i = 0; i < count; i++) {
+            list.push_back(person("member"));
+        }
+        distlist.setMembers(list);
+        return distlist;
+    }
+
+    Kolab::Note note()
+    {
+        Kolab::Note note;
+        note.setUid(uid());
+        note.setCreated(Kolab::cDateTime(2013, 1, 1, 12, 0, 0, true));
+        note.setLastModified(Kolab::cDateTime(2013, 1, 2, 12, 0, 0, true));
+        note.setSummary(text(30));
+        note.setDescription(text(random(Range(0, 5000))));
+        return note;
+    }
+
+    Kolab::Configuration configuration()
+    {
+        Kolab::Relation relation(text(10), "tag");
+        const int count = random(relationMembers);
+        std::vector<std::string> list;
+        list.reserve(static_cast<size_t>(count));
+        for (int i = 0; i < count; i++) {
+            list.push_back("imap:///user/someone/Calendar/" + uid());
+        }
+        relation.setMembers(list);
+        Kolab::Configuration configuration(relation);
+        configuration.setUid(uid());
+        configuration.setCreated(Kolab::cDateTime(2013, 1, 1, 12, 0, 0, true));
+        configuration.setLastModified(Kolab::cDateTime(2013, 1, 2, 12, 0, 0, true));
+        return configuration;
+    }
+
+    Kolab::File file()
+    {
+        Kolab::File file;
+        file.setUid(uid());
+        file.setCreated(Kolab::cDateTime(2013, 1, 1, 12, 0, 0, true));
+        file.setLastModified(Kolab::cDateTime(2013, 1, 2, 12, 0, 0, true));
+        Kolab::Attachment attachment;
+        attachment.setData(text(random(attachmentSize)), "application/octet-stream");
+        attachment.setLabel(text(10) + ".bin");
+        file.setFile(attachment);
+        return file;
+    }
+
+    const unsigned int mSeed;
+    boost::random::mt19937 mRandom;
+    int mCount;
+};
+
+int main(int argc, char *argv[])
+{
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "produce help message")
+        ("seed", po::value<unsigned int>()->default_value(1), "seed of the random generator, the same seed produces the same corpus")
+        ("count", po::value<int>()->default_value(100), "number of objects to generate")
+        ("types", po::value<std::vector<std::string> >()->multitoken(), "object types to choose from (event, todo, journal, freebusy, contact, distlist, note, configuration, file), defaults to all")
+        ("attendees", po::value<std::string>()->default_value("0:10"), "attendees per incidence (also freebusy periods)")
+        ("exceptions", po::value<std::string>()->default_value("0:0"), "exceptions per event or todo")
+        ("recurrence", po::value<std::string>()->default_value("0:3"), "recurrence complexity (0: none, 1: daily/weekly with count, 2: weekly by day until a date, 3: monthly by day and month with exception and recurrence dates)")
+        ("photo-size", po::value<std::string>()->default_value("0:20000"), "bytes of contact photos")
+        ("members", po::value<std::string>()->default_value("1:50"), "members per distlist")
+        ("relation-members", po::value<std::string>()->default_value("1:20"), "members per relation configuration")
+        ("attachment-size", po::value<std::string>()->default_value("100:100000"), "bytes of file attachments")
+        ("output-dir", po::value<std::string>(), "write each object to <dir>/<type>-<number>.xml")
+        ("stream", "write all objects to stdout, each preceded by a line with its type and size in bytes")
+    ;
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help") || (!vm.count("output-dir") && !vm.count("stream"))) {
+        cout << desc << "\n";
+        return 1;
+    }
+
+    Generator generator(vm["seed"].as<unsigned int>());
+    if (!parseRange(vm["attendees"].as<std::string>(), generator.attendees) ||
+        !parseRange(vm["exceptions"].as<std::string>(), generator.exceptions) ||
+        !parseRange(vm["recurrence"].as<std::string>(), generator.recurrence) ||
+        !parseRange(vm["photo-size"].as<std::string>(), generator.photoSize) ||
+        !parseRange(vm["members"].as<std::string>(), generator.members) ||
+        !parseRange(vm["relation-members"].as<std::string>(), generator.relationMembers) ||
+        !parseRange(vm["attachment-size"].as<std::string>(), generator.attachmentSize)) {
+        return -1;
+    }
+
+    vector<string> types;
+    if (vm.count("types")) {
+        types = vm["types"].as< vector<string> >();
+    } else {
+        const char *all[] = { "event", "todo", "journal", "freebusy", "contact", "distlist", "note", "configuration", "file" };
+        types.assign(all, all + sizeof(all) / sizeof(all[0]));
+    }
+
+    //The timestamps which are not set explicitly
+    Kolab::overrideTimestamp(Kolab::cDateTime(2013, 1, 3, 12, 0, 0, true));
+
+    const int count = vm["count"].as<int>();
+    for (int i = 0; i < count; i++) {
+        const string &type = types.at(static_cast<size_t>(generator.random(Range(0, static_cast<int>(types.size()) - 1))));
+        const string object = generator.next(type);
+        if (object.empty() || Kolab::errorOccurred()) {
+            cerr << "Error while generating " << type << ": " << Kolab::errorMessage() << endl;
+            return -1;
+        }
+        if (vm.count("stream")) {
+            cout << type << " " << object.size() << "\n" << object;
+        } else {
+            ostringstream name;
+            name << vm["output-dir"].as<std::string>() << "/" << type << "-" << i << ".xml";
+            ofstream file(name.str().c_str(), ios::out | ios::binary);
+            file << object;
+            if (!file) {
+                cerr << "Failed to write " << name.str() << endl;
+                return -1;
+            }
+        }
+    }
+    return 0;
+}